@@ -18,6 +18,15 @@
 #define VERTEX_ATTRIBUTE_TANGENT_NAME               "a_tangent"
 #define VERTEX_ATTRIBUTE_BINORMAL_NAME              "a_binormal"
 #define VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME       "a_texCoord"
+#define VERTEX_ATTRIBUTE_BONE_INDEX_NAME            "a_boneIndex"
+#define VERTEX_ATTRIBUTE_TEXTURE_ANIMATION_NAME     "a_textureAnimation"
+
+// Uniform block holding the per-frame data shared by all programs; its contents are defined by the application
+#define UNIFORM_BLOCK_FRAME_NAME                    "Frame"
+#define UNIFORM_BLOCK_FRAME_BINDING                 0
+// Uniform block holding the lighting of the items, selected per node; its contents are defined by the application
+#define UNIFORM_BLOCK_ITEM_LIGHTING_NAME            "ItemLighting"
+#define UNIFORM_BLOCK_ITEM_LIGHTING_BINDING         1
 
 
 /**
@@ -1,5 +1,6 @@
 #include "Game.h"
 
+#include "Camera.h"
 #include "RenderContext.h"
 #include "Scene.h"
 
@@ -147,7 +148,7 @@ namespace gameplay
 
             void visit(Node& node) override
             {
-                if( !node.isEnabled() )
+                if( !node.isEnabled() || node.isCulled() )
                 {
                     return;
                 }
@@ -171,9 +172,18 @@ namespace gameplay
     {
         clear(CLEAR_COLOR_DEPTH, {0, 0, 0, 0}, 1);
 
+        BOOST_ASSERT(_scene->getActiveCamera() != nullptr);
+
+        // Collect the parts of all visible models first, and then draw them sorted by their state.
         RenderContext context{wireframe};
+        _renderQueue.reset(_scene->getActiveCamera()->getViewMatrix());
+        context.setRenderQueue(&_renderQueue);
+
         RenderVisitor visitor{context};
         _scene->accept(visitor);
+
+        context.setRenderQueue(nullptr);
+        _renderQueue.submit(context);
     }
 
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Rectangle.h"
+#include "RenderQueue.h"
 #include "RenderState.h"
 
 #include "gl/pixel.h"
@@ -238,6 +239,15 @@ namespace gameplay
             return _scene;
         }
 
+
+        /**
+         * Gets the render queue used for drawing the scene, e.g. for its statistics.
+         */
+        const RenderQueue& getRenderQueue() const
+        {
+            return _renderQueue;
+        }
+
     protected:
 
         /**
@@ -281,6 +291,8 @@ namespace gameplay
 
         std::shared_ptr<Scene> _scene;
 
+        RenderQueue _renderQueue;
+
         friend class ScreenDisplayer;
     };
 
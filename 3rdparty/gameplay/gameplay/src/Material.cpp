@@ -3,6 +3,7 @@
 #include "ShaderProgram.h"
 #include "Node.h"
 #include "MaterialParameter.h"
+#include "RenderContext.h"
 
 #include <boost/log/trivial.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -30,14 +31,28 @@ namespace gameplay
     }
 
 
-    void Material::bind(const Node& node)
+    void Material::bind(RenderContext& context)
     {
         BOOST_ASSERT(_shaderProgram != nullptr);
+        BOOST_ASSERT(context.getCurrentNode() != nullptr);
 
-        // Bind our effect.
-        _shaderProgram->bind();
+        // Bind our effect, unless it's still bound from the previous draw call.
+        if( context.getBoundProgram() != _shaderProgram.get() )
+        {
+            _shaderProgram->bind();
+            context.setBoundProgram(_shaderProgram.get());
+        }
+
+        // Bind our render state, unless it's still bound from the previous draw call.
+        if( context.isMaterialBound(this) )
+        {
+            RenderState::bindNodeParameters(*context.getCurrentNode(), *context.getBoundMaterialNode(), this);
+        }
+        else
+        {
+            RenderState::bind(*context.getCurrentNode(), this);
+        }
 
-        // Bind our render state
-        RenderState::bind(node, this);
+        context.setBoundMaterial(this, context.getCurrentNode());
     }
 }
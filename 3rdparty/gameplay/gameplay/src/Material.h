@@ -6,6 +6,9 @@
 
 namespace gameplay
 {
+    class RenderContext;
+
+
     /**
      * Defines a material for an object to be rendered.
      *
@@ -44,7 +47,7 @@ namespace gameplay
             return _shaderProgram;
         }
 
-        void bind(const Node& node);
+        void bind(RenderContext& context);
 
     private:
 
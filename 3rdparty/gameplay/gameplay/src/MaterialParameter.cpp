@@ -6,12 +6,23 @@
 
 #include <boost/log/trivial.hpp>
 
+#include <unordered_map>
+
 
 namespace gameplay
 {
     MaterialParameter::MaterialParameter(const std::string& name)
         : m_name(name)
+        , m_id(getParameterId(name))
+    {
+    }
+
+
+    size_t MaterialParameter::getParameterId(const std::string& name)
     {
+        static std::unordered_map<std::string, size_t> ids;
+
+        return ids.emplace(name, ids.size()).first->second;
     }
 
 
@@ -26,19 +37,19 @@ namespace gameplay
 
     void MaterialParameter::set(float value)
     {
-        m_valueSetter = [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(value);
-            };
+            });
     }
 
 
     void MaterialParameter::set(int value)
     {
-        m_valueSetter = [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(value);
-            };
+            });
     }
 
 
@@ -46,10 +57,10 @@ namespace gameplay
     {
         std::vector<float> tmp;
         tmp.assign(values, values + count);
-        m_valueSetter = [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(tmp.data(), gsl::narrow<GLsizei>(tmp.size()));
-            };
+            });
     }
 
 
@@ -57,19 +68,19 @@ namespace gameplay
     {
         std::vector<int> tmp;
         tmp.assign(values, values + count);
-        m_valueSetter = [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(tmp.data(), gsl::narrow<GLsizei>(tmp.size()));
-            };
+            });
     }
 
 
     void MaterialParameter::set(const glm::vec2& value)
     {
-        m_valueSetter = [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(value);
-            };
+            });
     }
 
 
@@ -77,19 +88,19 @@ namespace gameplay
     {
         std::vector<glm::vec2> tmp;
         tmp.assign(values, values + count);
-        m_valueSetter = [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(tmp.data(), gsl::narrow<GLsizei>(tmp.size()));
-            };
+            });
     }
 
 
     void MaterialParameter::set(const glm::vec3& value)
     {
-        m_valueSetter = [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(value);
-            };
+            });
     }
 
 
@@ -97,19 +108,19 @@ namespace gameplay
     {
         std::vector<glm::vec3> tmp;
         tmp.assign(values, values + count);
-        m_valueSetter = [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(tmp.data(), gsl::narrow<GLsizei>(tmp.size()));
-            };
+            });
     }
 
 
     void MaterialParameter::set(const glm::vec4& value)
     {
-        m_valueSetter = [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(value);
-            };
+            });
     }
 
 
@@ -117,19 +128,19 @@ namespace gameplay
     {
         std::vector<glm::vec4> tmp;
         tmp.assign(values, values + count);
-        m_valueSetter = [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(tmp.data(), gsl::narrow<GLsizei>(tmp.size()));
-            };
+            });
     }
 
 
     void MaterialParameter::set(const glm::mat4& value)
     {
-        m_valueSetter = [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [value](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(value);
-            };
+            });
     }
 
 
@@ -137,37 +148,41 @@ namespace gameplay
     {
         std::vector<glm::mat4> tmp;
         tmp.assign(values, values + count);
-        m_valueSetter = [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [tmp](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(tmp.data(), gsl::narrow<GLsizei>(tmp.size()));
-            };
+            });
     }
 
 
     void MaterialParameter::set(const std::shared_ptr<gl::Texture>& texture)
     {
-        m_valueSetter = [texture](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [texture](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(*texture);
-            };
+            });
     }
 
 
     void MaterialParameter::set(const std::vector<std::shared_ptr<gl::Texture> >& textures)
     {
-        m_valueSetter = [textures](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+        setValueSetter(false, [textures](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
             {
                 uniform.set(textures);
-            };
+            });
     }
 
 
     gl::Program::ActiveUniform* MaterialParameter::getUniform(const std::shared_ptr<ShaderProgram>& shaderProgram)
     {
-        auto uniform = shaderProgram->getUniform(m_name);
+        if( m_uniformProgram == shaderProgram.get() )
+            return m_uniform;
 
-        if( uniform )
-            return uniform;
+        m_uniformProgram = shaderProgram.get();
+        m_uniform = shaderProgram->getUniform(m_name);
+
+        if( m_uniform )
+            return m_uniform;
 
         if( (m_loggerDirtyBits & UNIFORM_NOT_FOUND) == 0 )
         {
@@ -184,8 +199,8 @@ namespace gameplay
     {
         BOOST_ASSERT(shaderProgram);
 
-        const auto mpsIt = node.getMaterialParameterSetters().find(m_name);
-        if( !m_valueSetter && mpsIt == node.getMaterialParameterSetters().end() )
+        const auto nodeSetter = node.findMaterialParameterSetter(m_id);
+        if( !m_valueSetter && nodeSetter == nullptr )
         {
             if( (m_loggerDirtyBits & PARAMETER_VALUE_NOT_SET) == 0 )
             {
@@ -200,33 +215,52 @@ namespace gameplay
         if( uniform == nullptr )
             return;
 
-        if(mpsIt != node.getMaterialParameterSetters().end())
-            mpsIt->second(node, *uniform);
+        if( nodeSetter != nullptr )
+            (*nodeSetter)(node, *uniform);
         else
             (*m_valueSetter)(node, *uniform);
+
+        m_dirty = false;
+    }
+
+
+    bool MaterialParameter::needsRebind(const Node& node, const Node& previousNode) const
+    {
+        return m_dirty
+               || m_nodeDependent
+               || node.findMaterialParameterSetter(m_id) != nullptr
+               || previousNode.findMaterialParameterSetter(m_id) != nullptr;
+    }
+
+
+    void MaterialParameter::setValueSetter(bool nodeDependent, std::function<UniformValueSetter>&& setter)
+    {
+        m_valueSetter = std::move(setter);
+        m_nodeDependent = nodeDependent;
+        m_dirty = true;
     }
 
     void MaterialParameter::bindWorldViewProjectionMatrix()
     {
-        m_valueSetter = [](const Node& node, gl::Program::ActiveUniform& uniform)
+        setValueSetter(true, [](const Node& node, gl::Program::ActiveUniform& uniform)
         {
             uniform.set(node.getWorldViewProjectionMatrix());
-        };
+        });
     }
 
     void MaterialParameter::bindModelMatrix()
     {
-        m_valueSetter = [](const Node& node, gl::Program::ActiveUniform& uniform)
+        setValueSetter(true, [](const Node& node, gl::Program::ActiveUniform& uniform)
         {
             uniform.set(node.getWorldMatrix());
-        };
+        });
     }
 
     void MaterialParameter::bindViewMatrix()
     {
-        m_valueSetter = [](const Node& node, gl::Program::ActiveUniform& uniform)
+        setValueSetter(true, [](const Node& node, gl::Program::ActiveUniform& uniform)
         {
             uniform.set(node.getViewMatrix());
-        };
+        });
     }
 }
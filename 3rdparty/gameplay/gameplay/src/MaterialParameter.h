@@ -46,6 +46,13 @@ namespace gameplay
          */
         const std::string& getName() const;
 
+        /**
+         * Returns the process-wide unique id of a parameter name.
+         *
+         * Lookups at draw time use this id instead of the name.
+         */
+        static size_t getParameterId(const std::string& name);
+
         /**
          * Sets the value of this parameter to a float value.
          */
@@ -136,17 +143,18 @@ namespace gameplay
         template<class ClassType, class ValueType>
         void bind(ClassType* classInstance, ValueType (ClassType::*valueMethod)() const)
         {
-            m_valueSetter = [classInstance, valueMethod](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
+            setValueSetter(false, [classInstance, valueMethod](const Node& /*node*/, gl::Program::ActiveUniform& uniform)
                 {
                     uniform.set((classInstance ->* valueMethod)());
-                };
+                });
         }
 
         using UniformValueSetter = void(const Node& node, gl::Program::ActiveUniform& uniform);
 
+        //! The setter is assumed to depend on the node it is called for, see needsRebind()
         void bind(std::function<UniformValueSetter>&& setter)
         {
-            m_valueSetter = std::move(setter);
+            setValueSetter(true, std::move(setter));
         }
 
         /**
@@ -165,10 +173,10 @@ namespace gameplay
         template<class ClassType, class ValueType>
         void bind(ClassType* classInstance, ValueType (ClassType::*valueMethod)() const, size_t (ClassType::*countMethod)() const)
         {
-            m_valueSetter = [classInstance, valueMethod, countMethod](const Node& /*node*/, const gl::Program::ActiveUniform& uniform)
+            setValueSetter(false, [classInstance, valueMethod, countMethod](const Node& /*node*/, const gl::Program::ActiveUniform& uniform)
                 {
                     uniform.set((classInstance ->* valueMethod)(), (classInstance ->* countMethod)());
-                };
+                });
         }
 
         void bindWorldViewProjectionMatrix();
@@ -183,6 +191,15 @@ namespace gameplay
 
         gl::Program::ActiveUniform* getUniform(const std::shared_ptr<ShaderProgram>& shaderProgram);
 
+        /**
+         * Whether the parameter must be bound again for @a node, if its material is still bound for @a previousNode.
+         *
+         * That is the case if its value changed since it was bound, depends on the node, or either node overrides it.
+         */
+        bool needsRebind(const Node& node, const Node& previousNode) const;
+
+        void setValueSetter(bool nodeDependent, std::function<UniformValueSetter>&& setter);
+
 
         enum LOGGER_DIRTYBITS
         {
@@ -191,7 +208,16 @@ namespace gameplay
         };
 
         const std::string m_name;
+        const size_t m_id;
         boost::optional<std::function<UniformValueSetter>> m_valueSetter;
+        //! Whether m_valueSetter uses the node it is called for, e.g. for the model matrix
+        bool m_nodeDependent = false;
+        //! Whether m_valueSetter changed since the parameter was bound last
+        bool m_dirty = true;
         uint8_t m_loggerDirtyBits = 0;
+
+        //! The program m_uniform was resolved for; a parameter is normally only ever bound to the program of its material
+        const ShaderProgram* m_uniformProgram = nullptr;
+        gl::Program::ActiveUniform* m_uniform = nullptr;
     };
 }
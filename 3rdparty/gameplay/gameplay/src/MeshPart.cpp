@@ -2,6 +2,7 @@
 
 #include "Drawable.h"
 #include "Material.h"
+#include "Node.h"
 #include "RenderContext.h"
 
 
@@ -166,7 +167,7 @@ namespace gameplay
         for(const auto& mps : _materialParameterSetters)
             mps(*_material);
 
-        _material->bind(*context.getCurrentNode());
+        _material->bind(context);
 
         if(m_vao == nullptr)
         {
@@ -180,7 +181,13 @@ namespace gameplay
 
         m_vao->bind();
 
-        if(!context.isWireframe() || !drawWireframe())
+        const auto instanceCount = context.getCurrentNode()->getInstanceCount();
+        if(instanceCount != 1)
+        {
+            // wireframe rendering isn't supported for instanced nodes
+            GL_ASSERT(glDrawElementsInstanced(_primitiveType, gsl::narrow<GLsizei>(_indexCount), static_cast<GLenum>(_indexFormat), nullptr, gsl::narrow<GLsizei>(instanceCount)));
+        }
+        else if(!context.isWireframe() || !drawWireframe())
         {
             GL_ASSERT(glDrawElements(_primitiveType, gsl::narrow<GLsizei>(_indexCount), static_cast<GLenum>(_indexFormat), nullptr));
         }
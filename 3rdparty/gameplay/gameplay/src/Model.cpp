@@ -3,6 +3,7 @@
 #include "MeshPart.h"
 #include "Node.h"
 #include "MaterialParameter.h"
+#include "RenderQueue.h"
 
 #include <boost/log/trivial.hpp>
 
@@ -21,6 +22,8 @@ namespace gameplay
 
     void Model::draw(RenderContext& context)
     {
+        auto queue = context.getRenderQueue();
+
         for( const auto& mesh : _meshes )
         {
             BOOST_ASSERT(mesh);
@@ -29,7 +32,15 @@ namespace gameplay
             {
                 BOOST_ASSERT(part);
 
-                part->draw(context);
+                if( queue != nullptr )
+                {
+                    BOOST_ASSERT(context.getCurrentNode() != nullptr);
+                    queue->add(*part, *context.getCurrentNode());
+                }
+                else
+                {
+                    part->draw(context);
+                }
             }
         }
     }
@@ -87,6 +87,42 @@ namespace gameplay
          */
         bool isEnabled() const;
 
+        /**
+         * Sets if the node is known to be invisible in the current frame.
+         *
+         * Unlike the enabled state, this is updated by the visibility tests of the application
+         * every frame.  Culled nodes and their children are not drawn.
+         *
+         * @param culled if the node is skipped when drawing.
+         */
+        void setCulled(bool culled) noexcept
+        {
+            _culled = culled;
+        }
+
+        bool isCulled() const noexcept
+        {
+            return _culled;
+        }
+
+        /**
+         * Sets how many times the drawable is drawn, using instanced draw calls.
+         *
+         * The per-instance data must be provided to the shaders by the application, e.g. through
+         * material parameter setters of this node, indexed by gl_InstanceID.
+         *
+         * @param count the number of instances.
+         */
+        void setInstanceCount(size_t count) noexcept
+        {
+            _instanceCount = count;
+        }
+
+        size_t getInstanceCount() const noexcept
+        {
+            return _instanceCount;
+        }
+
         /**
          * Gets if the node inherently enabled.
          *
@@ -289,19 +325,41 @@ namespace gameplay
 
         void addMaterialParameterSetter(const std::string& name, const std::function<MaterialParameter::UniformValueSetter>& setter)
         {
-            _materialParemeterSetters[name] = setter;
+            addMaterialParameterSetter(name, std::function<MaterialParameter::UniformValueSetter>{setter});
         }
 
 
         void addMaterialParameterSetter(const std::string& name, std::function<MaterialParameter::UniformValueSetter>&& setter)
         {
-            _materialParemeterSetters[name] = std::move(setter);
+            const auto id = MaterialParameter::getParameterId(name);
+            for( auto& entry : _materialParemeterSetters )
+            {
+                if( entry.first == id )
+                {
+                    entry.second = std::move(setter);
+                    return;
+                }
+            }
+
+            _materialParemeterSetters.emplace_back(id, std::move(setter));
         }
 
 
-        const std::map<std::string, std::function<MaterialParameter::UniformValueSetter>>& getMaterialParameterSetters() const
+        /**
+         * Gets the setter overriding the material parameter with the given id for this node, or nullptr.
+         *
+         * @see MaterialParameter::getParameterId()
+         */
+        const std::function<MaterialParameter::UniformValueSetter>* findMaterialParameterSetter(size_t id) const
         {
-            return _materialParemeterSetters;
+            // nodes only override a handful of parameters, so a linear search beats any lookup structure
+            for( const auto& entry : _materialParemeterSetters )
+            {
+                if( entry.first == id )
+                    return &entry.second;
+            }
+
+            return nullptr;
         }
 
 
@@ -330,6 +388,10 @@ namespace gameplay
 
         /** If this node is enabled. Maybe different if parent is enabled/disabled. */
         bool _enabled = true;
+        /** If this node is skipped when drawing the current frame. */
+        bool _culled = false;
+        /** The number of instances of the drawable. */
+        size_t _instanceCount = 1;
         /** The drawble component attached to this node. */
         std::shared_ptr<Drawable> _drawable = nullptr;
 
@@ -337,6 +399,6 @@ namespace gameplay
         mutable glm::mat4 m_worldMatrix{1.0f};
         mutable bool _dirty = false;
 
-        std::map<std::string, std::function<MaterialParameter::UniformValueSetter>> _materialParemeterSetters;
+        std::vector<std::pair<size_t, std::function<MaterialParameter::UniformValueSetter>>> _materialParemeterSetters;
     };
 }
@@ -2,7 +2,10 @@
 
 namespace gameplay
 {
+    class Material;
     class Node;
+    class RenderQueue;
+    class ShaderProgram;
 
     class RenderContext
     {
@@ -30,8 +33,67 @@ namespace gameplay
         }
 
 
+        /**
+         * If set, models queue their parts here instead of drawing them immediately.
+         */
+        RenderQueue* getRenderQueue() const noexcept
+        {
+            return m_renderQueue;
+        }
+
+
+        void setRenderQueue(RenderQueue* queue) noexcept
+        {
+            m_renderQueue = queue;
+        }
+
+
+        /**
+         * The shader program bound last within this context, to avoid re-binding it for every draw call.
+         */
+        const ShaderProgram* getBoundProgram() const noexcept
+        {
+            return m_boundProgram;
+        }
+
+
+        void setBoundProgram(const ShaderProgram* program) noexcept
+        {
+            m_boundProgram = program;
+        }
+
+
+        /**
+         * The material bound last within this context, and the node it was bound for.
+         *
+         * Drawing the same material again only needs to apply the parameters that differ between the
+         * nodes; the render queue resets this when it starts drawing, see RenderQueue::submit().
+         */
+        bool isMaterialBound(const Material* material) const noexcept
+        {
+            return m_boundMaterial == material && m_boundMaterialNode != nullptr;
+        }
+
+
+        const Node* getBoundMaterialNode() const noexcept
+        {
+            return m_boundMaterialNode;
+        }
+
+
+        void setBoundMaterial(const Material* material, const Node* node) noexcept
+        {
+            m_boundMaterial = material;
+            m_boundMaterialNode = node;
+        }
+
+
     private:
         Node* m_currentNode = nullptr;
+        RenderQueue* m_renderQueue = nullptr;
+        const ShaderProgram* m_boundProgram = nullptr;
+        const Material* m_boundMaterial = nullptr;
+        const Node* m_boundMaterialNode = nullptr;
         const bool m_wireframe;
     };
 }
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "RenderQueue.h"
+
+#include "Material.h"
+#include "MeshPart.h"
+#include "Node.h"
+#include "RenderContext.h"
+
+#include "gl/debuggroup.h"
+
+#include <algorithm>
+#include <functional>
+
+
+namespace gameplay
+{
+    void RenderQueue::reset(const glm::mat4& viewMatrix)
+    {
+        _entries.clear();
+        _viewMatrix = viewMatrix;
+    }
+
+
+    void RenderQueue::add(const MeshPart& part, Node& node)
+    {
+        const auto& material = part.getMaterial();
+        if( material == nullptr )
+            return;
+
+        const auto& state = material->getStateBlock();
+
+        Entry entry;
+        entry.part = &part;
+        entry.node = &node;
+        entry.program = material->getShaderProgram().get();
+        entry.material = material.get();
+        entry.transparent = state != nullptr && state->isBlending();
+        // the camera looks along -z in view space
+        entry.depth = -(_viewMatrix * glm::vec4(node.getTranslationWorld(), 1)).z;
+
+        _entries.emplace_back(entry);
+    }
+
+
+    void RenderQueue::submit(RenderContext& context)
+    {
+        gl::DebugGroup debugGroup{"RenderQueue"};
+
+        std::sort(_entries.begin(), _entries.end(), [](const Entry& a, const Entry& b)
+                  {
+                      if( a.transparent != b.transparent )
+                          return !a.transparent;
+
+                      if( a.transparent )
+                          return a.depth > b.depth;
+
+                      if( a.program != b.program )
+                          return std::less<const ShaderProgram*>()(a.program, b.program);
+
+                      if( a.material != b.material )
+                          return std::less<const Material*>()(a.material, b.material);
+
+                      return a.depth < b.depth;
+                  });
+
+        _statistics = Statistics{};
+
+        // the GL state may have been changed since the last material was bound
+        context.setBoundMaterial(nullptr, nullptr);
+        const auto previousNode = context.getCurrentNode();
+        for( const auto& entry : _entries )
+        {
+            if( entry.program != context.getBoundProgram() )
+                ++_statistics.programChanges;
+
+            // consecutive parts of the same material only apply the parameters that differ between their nodes
+            if( context.isMaterialBound(entry.material) )
+                ++_statistics.skippedMaterialBinds;
+            else
+                ++_statistics.materialBinds;
+
+            context.setCurrentNode(entry.node);
+            entry.part->draw(context);
+            ++_statistics.drawCalls;
+        }
+        context.setCurrentNode(previousNode);
+        context.setBoundMaterial(nullptr, nullptr);
+
+        _entries.clear();
+    }
+}
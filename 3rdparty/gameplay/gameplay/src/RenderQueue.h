@@ -0,0 +1,85 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+namespace gameplay
+{
+    class Material;
+    class MeshPart;
+    class Node;
+    class RenderContext;
+    class ShaderProgram;
+
+
+    /**
+     * Collects the visible mesh parts of a frame and draws them sorted by render state.
+     *
+     * Opaque parts are grouped by shader program and material and drawn front-to-back within
+     * each group; transparent parts (those whose material enables blending) are drawn last,
+     * back-to-front. Shader programs are only bound when they change, and materials drawn again
+     * for another node only bind the parameters differing between the nodes.
+     */
+    class RenderQueue
+    {
+    public:
+        struct Statistics
+        {
+            size_t drawCalls = 0;
+            size_t programChanges = 0;
+            //! Materials bound with their render state and all parameters
+            size_t materialBinds = 0;
+            //! Draw calls that kept the material of the previous one, and only bound the parameters differing between the nodes
+            size_t skippedMaterialBinds = 0;
+        };
+
+
+        explicit RenderQueue() = default;
+
+        /**
+         * Discards all queued parts and starts a new frame.
+         *
+         * @param viewMatrix The view matrix of the camera, used to compute the depth of the parts.
+         */
+        void reset(const glm::mat4& viewMatrix);
+
+        /**
+         * Queues a mesh part for drawing with the transformation and parameters of the given node.
+         */
+        void add(const MeshPart& part, Node& node);
+
+        /**
+         * Sorts and draws all queued parts.
+         */
+        void submit(RenderContext& context);
+
+        /**
+         * Gets the counters of the last submitted frame.
+         */
+        const Statistics& getStatistics() const
+        {
+            return _statistics;
+        }
+
+    private:
+        struct Entry
+        {
+            const MeshPart* part;
+            Node* node;
+            const ShaderProgram* program;
+            const Material* material;
+            bool transparent;
+            float depth;
+        };
+
+        RenderQueue(const RenderQueue&) = delete;
+
+        RenderQueue& operator=(const RenderQueue&) = delete;
+
+        std::vector<Entry> _entries;
+        glm::mat4 _viewMatrix{1.0f};
+        Statistics _statistics;
+    };
+}
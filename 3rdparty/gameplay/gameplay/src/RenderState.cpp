@@ -156,7 +156,7 @@ namespace gameplay
 
         // Apply parameter bindings and renderer state for the entire hierarchy, top-down.
         rs = nullptr;
-        auto shader = material->getShaderProgram();
+        const auto& shader = material->getShaderProgram();
         while( (rs = getTopmost(rs)) )
         {
             for( const auto& param : rs->_parameters )
@@ -173,6 +173,25 @@ namespace gameplay
     }
 
 
+    void RenderState::bindNodeParameters(const Node& node, const Node& previousNode, Material* material)
+    {
+        BOOST_ASSERT(material);
+
+        // The renderer state is unchanged, so only the parameters are applied, top-down.
+        RenderState* rs = nullptr;
+        const auto& shader = material->getShaderProgram();
+        while( (rs = getTopmost(rs)) )
+        {
+            for( const auto& param : rs->_parameters )
+            {
+                BOOST_ASSERT(param);
+                if( param->needsRebind(node, previousNode) )
+                    param->bind(node, shader);
+            }
+        }
+    }
+
+
     RenderState* RenderState::getTopmost(const RenderState* below)
     {
         RenderState* rs = this;
@@ -369,6 +388,12 @@ namespace gameplay
     }
 
 
+    bool RenderState::StateBlock::isBlending() const
+    {
+        return (_bits & RS_BLEND) != 0 && _blendEnabled;
+    }
+
+
     void RenderState::StateBlock::setBlend(bool enabled)
     {
         _blendEnabled = enabled;
@@ -190,6 +190,11 @@ namespace gameplay
              */
             void setDepthFunction(DepthFunction func);
 
+            /**
+             * Returns true if this StateBlock explicitly enables blending.
+             */
+            bool isBlending() const;
+
         private:
 
             /**
@@ -325,6 +330,12 @@ namespace gameplay
          */
         void bind(const Node& node, Material* material);
 
+        /**
+         * Binds only the parameters that may differ between @a node and @a previousNode, if the render
+         * state is still bound for @a previousNode.
+         */
+        void bindNodeParameters(const Node& node, const Node& previousNode, Material* material);
+
         /**
          * Returns the topmost RenderState in the hierarchy below the given RenderState.
          */
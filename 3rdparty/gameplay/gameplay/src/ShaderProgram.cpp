@@ -260,6 +260,9 @@ namespace gameplay
             return nullptr;
         }
 
+        shaderProgram->m_handle.bindUniformBlock(UNIFORM_BLOCK_FRAME_NAME, UNIFORM_BLOCK_FRAME_BINDING);
+        shaderProgram->m_handle.bindUniformBlock(UNIFORM_BLOCK_ITEM_LIGHTING_NAME, UNIFORM_BLOCK_ITEM_LIGHTING_BINDING);
+
         // Query and store vertex attribute meta-data from the program.
         // NOTE: Rather than using glBindAttribLocation to explicitly specify our own
         // preferred attribute locations, we're going to query the locations that were
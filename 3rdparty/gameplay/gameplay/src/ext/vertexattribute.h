@@ -61,6 +61,12 @@ public:
     }
 
 
+    GLint getSize() const noexcept
+    {
+        return m_size;
+    }
+
+
 private:
     const GLenum m_type;
 
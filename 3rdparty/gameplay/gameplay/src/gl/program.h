@@ -50,6 +50,25 @@ namespace gameplay
             }
 
 
+            /**
+             * Associates a uniform block with an indexed binding point of uniform buffers.
+             *
+             * @returns false if the program has no active uniform block with that name.
+             */
+            // ReSharper disable once CppMemberFunctionMayBeConst
+            bool bindUniformBlock(const std::string& name, GLuint bindingPoint)
+            {
+                const auto index = glGetUniformBlockIndex(getHandle(), name.c_str());
+                checkGlError();
+                if( index == GL_INVALID_INDEX )
+                    return false;
+
+                glUniformBlockBinding(getHandle(), index, bindingPoint);
+                checkGlError();
+                return true;
+            }
+
+
             bool getLinkStatus() const
             {
                 GLint success = GL_FALSE;
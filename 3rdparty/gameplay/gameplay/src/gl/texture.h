@@ -131,6 +131,70 @@ namespace gameplay
             }
 
 
+            /**
+             * @brief Allocates storage for a layered texture; the layers are filled using subImage3D().
+             */
+            template<typename T>
+            void image3D(GLint width, GLint height, GLint depth, bool generateMipmaps)
+            {
+                BOOST_ASSERT(width > 0 && height > 0 && depth > 0);
+
+                bind();
+
+                glTexImage3D(m_type, 0, T::InternalFormat, width, height, depth, 0, T::Format, T::TypeId, nullptr);
+                checkGlError();
+
+                m_width = width;
+                m_height = height;
+                m_depth = depth;
+
+                set(GL_TEXTURE_MIN_FILTER, generateMipmaps ? GL_NEAREST_MIPMAP_LINEAR : GL_LINEAR);
+                checkGlError();
+
+                m_mipmap = generateMipmaps;
+            }
+
+
+            /**
+             * @brief Uploads a single layer of a texture allocated by image3D().
+             *
+             * Mipmaps are not updated, as this is usually done for all layers in a row; call
+             * generateMipmaps() after the last layer.
+             */
+            // ReSharper disable once CppMemberFunctionMayBeConst
+            template<typename T>
+            void subImage3D(GLint layer, const std::vector<T>& data)
+            {
+                BOOST_ASSERT(m_width > 0 && m_height > 0);
+                BOOST_ASSERT(layer >= 0 && layer < m_depth);
+                BOOST_ASSERT(static_cast<size_t>(m_width) * static_cast<size_t>(m_height) == data.size());
+
+                bind();
+
+                glTexSubImage3D(m_type, 0, 0, 0, layer, m_width, m_height, 1, T::Format, T::TypeId, data.data());
+                checkGlError();
+            }
+
+
+            // ReSharper disable once CppMemberFunctionMayBeConst
+            void generateMipmaps()
+            {
+                if( !m_mipmap )
+                    return;
+
+                bind();
+
+                glGenerateMipmap(m_type);
+                checkGlError();
+            }
+
+
+            GLint getDepth() const noexcept
+            {
+                return m_depth;
+            }
+
+
             void depthImage2D(GLint width, GLint height, GLint multisample = 0)
             {
                 BOOST_ASSERT(width > 0 && height > 0);
@@ -160,6 +224,8 @@ namespace gameplay
 
             GLint m_height = -1;
 
+            GLint m_depth = 1;
+
             bool m_mipmap = false;
         };
     }
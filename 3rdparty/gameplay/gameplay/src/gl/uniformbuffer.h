@@ -0,0 +1,48 @@
+#pragma once
+
+#include "bindableresource.h"
+
+
+namespace gameplay
+{
+    namespace gl
+    {
+        class UniformBuffer : public BindableResource
+        {
+        public:
+            explicit UniformBuffer(const std::string& label = {})
+                : BindableResource{glGenBuffers,
+                                   [](GLuint handle) { glBindBuffer(GL_UNIFORM_BUFFER, handle); },
+                                   glDeleteBuffers,
+                                   GL_BUFFER,
+                                   label}
+            {
+            }
+
+
+            /**
+             * Replaces the contents of the buffer.
+             *
+             * @param data The block data; its layout must match the uniform block, usually std140.
+             */
+            template<typename T>
+            void setData(const T& data, GLenum usage = GL_DYNAMIC_DRAW)
+            {
+                bind();
+                glBufferData(GL_UNIFORM_BUFFER, sizeof(T), &data, usage);
+                checkGlError();
+            }
+
+
+            /**
+             * Binds the buffer to an indexed binding point, so that it is used by the uniform blocks
+             * associated with it, see Program::bindUniformBlock().
+             */
+            void bindBase(GLuint bindingPoint) const
+            {
+                glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, getHandle());
+                checkGlError();
+            }
+        };
+    }
+}
@@ -3,11 +3,39 @@ attribute vec3 a_normal;
 // attribute vec2 a_texCoord;
 attribute vec3 a_color;
 
-uniform mat4 u_worldViewProjectionMatrix;
+#ifdef SKINNED
+// must match engine::SkeletalModelNode::MaxSkinnedBones
+const int MaxBones = 32;
+
+attribute float a_boneIndex;
+// bone transforms, relative to the model
+uniform mat4 u_bones[MaxBones];
+#else
+// must match render::InstancedNode::MaxInstances
+const int MaxInstances = 32;
+
+// if set, the mesh is drawn once per instance, see render::InstancedNode
+uniform bool u_instanced;
+// the translation of each instance, and its rotation around -y in w
+uniform vec4 u_instanceTransforms[MaxInstances];
+uniform float u_instanceBrightness[MaxInstances];
+
+mat4 getInstanceMatrix()
+{
+    vec4 transform = u_instanceTransforms[gl_InstanceID];
+    float s = sin(transform.w);
+    float c = cos(transform.w);
+    return mat4(c, 0, s, 0,
+                0, 1, 0, 0,
+                -s, 0, c, 0,
+                transform.xyz, 1);
+}
+#endif
+
+#include "frame.glsl"
+#include "itemlighting.glsl"
+
 uniform mat4 u_modelMatrix;
-uniform vec3 u_lightPosition;
-uniform float u_baseLight;
-uniform float u_baseLightDiff;
 
 // varying vec2 v_texCoord;
 varying vec3 v_color;
@@ -15,19 +43,30 @@ varying float v_shadeFactor;
 
 void main()
 {
-    gl_Position = u_worldViewProjectionMatrix * vec4(a_position, 1);
+    ItemLight light = u_itemLights[u_itemLight];
+
+    // the transform of the vertex relative to the model
+#ifdef SKINNED
+    mat4 meshMatrix = u_bones[int(a_boneIndex)];
+    float baseLight = light.base;
+#else
+    mat4 meshMatrix = u_instanced ? getInstanceMatrix() : mat4(1);
+    float baseLight = u_instanced ? u_instanceBrightness[gl_InstanceID] : light.base;
+#endif
+
+    gl_Position = u_viewProjection * u_modelMatrix * meshMatrix * vec4(a_position, 1);
     // v_texCoord = a_texCoord;
     v_color = a_color;
 
-    if(isnan(u_lightPosition.x))
+    if(isnan(light.position.x))
     {
-        v_shadeFactor = clamp(u_baseLight + u_baseLightDiff, 0, 1);
+        v_shadeFactor = clamp(baseLight + light.baseDiff, 0, 1);
         return;
     }
 
-    vec3 vertexPos = (u_modelMatrix * vec4(a_position, 1)).xyz;
-    vec3 n = normalize((u_modelMatrix * vec4(a_normal, 0)).xyz);
-    vec3 dir = normalize(vec4(u_lightPosition, 1).xyz - vertexPos);
+    vec3 vertexPos = (u_modelMatrix * meshMatrix * vec4(a_position, 1)).xyz;
+    vec3 n = normalize((u_modelMatrix * meshMatrix * vec4(a_normal, 0)).xyz);
+    vec3 dir = normalize(vec4(light.position, 1).xyz - vertexPos);
 
-    v_shadeFactor = clamp(u_baseLight + dot(n, dir) * u_baseLightDiff, 0, 1);
+    v_shadeFactor = clamp(baseLight + dot(n, dir) * light.baseDiff, 0, 1);
 }
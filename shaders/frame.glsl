@@ -0,0 +1,12 @@
+// per-frame data shared by all programs, see render::FrameUniforms
+layout(std140) uniform Frame
+{
+    mat4 u_view;
+    mat4 u_projection;
+    mat4 u_viewProjection;
+    vec4 u_cameraPosition;
+    // game time in milliseconds
+    float u_time;
+    // if the camera is under water
+    bool u_inWater;
+};
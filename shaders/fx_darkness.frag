@@ -1,6 +1,7 @@
 uniform sampler2D u_texture;
 uniform sampler2D u_depth;
-uniform mat4 u_projection;
+
+#include "frame.glsl"
 
 varying vec2 v_texCoord;
 
@@ -17,8 +18,6 @@ const float Z_max = 20480;
     const float Frq2 = 19.7;
     const float TimeMult2 = 0.002;
     const float Amplitude2 = 0.0125;
-
-    uniform float u_time;
 #endif
 
 #define DOF
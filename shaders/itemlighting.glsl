@@ -0,0 +1,18 @@
+// the lighting of all items, see render::ItemLighting
+const int MaxItemLights = 512;
+
+struct ItemLight
+{
+    // NaN if the item is lit without a direction
+    vec3 position;
+    float base;
+    float baseDiff;
+};
+
+layout(std140) uniform ItemLighting
+{
+    ItemLight u_itemLights[MaxItemLights];
+};
+
+// the entry of the item the node belongs to, or 0 if it is not lit by an item
+uniform int u_itemLight;
@@ -1,6 +1,12 @@
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray u_diffuseTexture;
+
+varying vec3 v_texCoord;
+#else
 uniform sampler2D u_diffuseTexture;
 
 varying vec2 v_texCoord;
+#endif
 varying vec3 v_color;
 varying float v_shadeFactor;
 
@@ -8,7 +14,11 @@ out vec4 out_color;
 
 void main()
 {
+#ifdef TEXTURE_ARRAY
+    vec4 baseColor = texture(u_diffuseTexture, v_texCoord);
+#else
     vec4 baseColor = texture2D(u_diffuseTexture, v_texCoord);
+#endif
 
     if(baseColor.a < 0.5)
         discard;
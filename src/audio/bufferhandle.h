@@ -43,6 +43,33 @@ namespace audio
             return m_handle;
         }
 
+        size_t getSize() const
+        {
+            ALint size = 0;
+            alGetBufferi(m_handle, AL_SIZE, &size);
+            DEBUG_CHECK_AL_ERROR();
+            return gsl::narrow<size_t>(size);
+        }
+
+        //! Playback length in seconds at normal pitch
+        float getDuration() const
+        {
+            ALint size = 0, bits = 0, channels = 0, frequency = 0;
+            alGetBufferi(m_handle, AL_SIZE, &size);
+            DEBUG_CHECK_AL_ERROR();
+            alGetBufferi(m_handle, AL_BITS, &bits);
+            DEBUG_CHECK_AL_ERROR();
+            alGetBufferi(m_handle, AL_CHANNELS, &channels);
+            DEBUG_CHECK_AL_ERROR();
+            alGetBufferi(m_handle, AL_FREQUENCY, &frequency);
+            DEBUG_CHECK_AL_ERROR();
+
+            if( bits <= 0 || channels <= 0 || frequency <= 0 )
+                return 0;
+
+            return static_cast<float>(size) / (bits / 8 * channels) / frequency;
+        }
+
         void fill(const int16_t* samples, size_t sampleCount, int channels, int sampleRate)
         {
             alBufferData(m_handle, channels == 2 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16, samples, gsl::narrow<ALsizei>(sampleCount * sizeof(samples[0])), sampleRate);
@@ -67,7 +94,7 @@ namespace audio
 
             BOOST_ASSERT(sfInfo.frames >= 0);
 
-            std::vector<int16_t> pcm(sfInfo.frames);
+            std::vector<int16_t> pcm(sfInfo.frames * sfInfo.channels);
             sf_readf_short(sfFile, pcm.data(), sfInfo.frames);
 
             alBufferData(m_handle, sfInfo.channels == 2 ? AL_FORMAT_STEREO16 : AL_FORMAT_MONO16, pcm.data(), gsl::narrow<ALsizei>(pcm.size() * sizeof(pcm[0])), sfInfo.samplerate);
@@ -11,6 +11,11 @@ namespace audio
             m_streamUpdater.join();
         }
 
+        // streams and sources must be released while the context still exists
+        m_streams.clear();
+        m_retiredStreams.clear();
+        m_voiceManager.reset();
+
         if( m_context )
         {
             alcMakeContextCurrent(nullptr);
@@ -130,6 +135,8 @@ namespace audio
         alFilterf(m_underwaterFilter->get(), AL_LOWPASS_GAINHF, 0.1f); // High frequencies gain.
         DEBUG_CHECK_AL_ERROR();
 
+        m_voiceManager = std::make_unique<VoiceManager>();
+
         m_streamUpdater = std::thread{
             [this]()
             {
@@ -141,7 +148,5 @@ namespace audio
                 }
             }
         };
-
-        m_streamUpdater.detach();
     }
 }
@@ -3,11 +3,16 @@
 #include "filterhandle.h"
 #include "sourcehandle.h"
 #include "stream.h"
+#include "voicemanager.h"
 
 #include <alc.h>
 #include <gsl/gsl>
+
+#include <atomic>
+#include <mutex>
 #include <set>
 #include <thread>
+#include <vector>
 
 
 namespace audio
@@ -19,10 +24,11 @@ public:
     explicit Device();
     ~Device();
 
+    //! Streams are updated on their own thread, so this only needs to be called from the game loop.
     void update()
     {
-        removeStoppedSources();
-        updateStreams();
+        if( m_voiceManager != nullptr )
+            m_voiceManager->update(m_listenerPosition);
     }
 
     const std::shared_ptr<FilterHandle>& getUnderwaterFilter() const
@@ -30,34 +36,48 @@ public:
         return m_underwaterFilter;
     }
 
-    void registerSource(const gsl::not_null<std::shared_ptr<SourceHandle>>& src)
+    void registerVoice(const gsl::not_null<std::shared_ptr<Voice>>& voice)
     {
-        m_sources.insert(src);
+        if( m_voiceManager != nullptr )
+            m_voiceManager->add(voice);
     }
 
     void registerStream(const gsl::not_null<std::shared_ptr<Stream>>& stream)
     {
+        std::lock_guard<std::mutex> lock{m_streamsMutex};
         m_streams.insert(stream);
     }
 
+    /**
+     * @brief Stops updating a stream.
+     *
+     * The device keeps a reference until its updater thread has released it, so that shutting down
+     * the stream's decoder doesn't block the caller.
+     */
     void removeStream(const std::shared_ptr<Stream>& stream)
     {
-        m_streams.erase(stream);
+        if( stream == nullptr )
+            return;
+
+        std::lock_guard<std::mutex> lock{m_streamsMutex};
+        if( m_streams.erase(stream) > 0 )
+            m_retiredStreams.emplace_back(stream);
     }
 
-    void removeStoppedSources()
+    //! Total number of underruns of all active streams
+    size_t getStreamUnderruns() const
     {
-        std::set<std::shared_ptr<SourceHandle>> cleaned;
-        std::copy_if(m_sources.begin(), m_sources.end(), std::inserter(cleaned, cleaned.end()), [](const std::shared_ptr<SourceHandle>& src)
-        {
-            return !src->isStopped();
-        });
-
-        m_sources = std::move(cleaned);
+        std::lock_guard<std::mutex> lock{m_streamsMutex};
+        size_t underruns = 0;
+        for( const auto& stream : m_streams )
+            underruns += stream->getUnderruns();
+        return underruns;
     }
 
     void setListenerTransform(const glm::vec3& pos, const glm::vec3& front, const glm::vec3& up)
     {
+        m_listenerPosition = pos;
+
         alListener3f(AL_POSITION, pos.x, pos.y, pos.z);
         DEBUG_CHECK_AL_ERROR();
 
@@ -71,23 +91,40 @@ public:
 
     void applyDirectFilterToAllSources(const std::shared_ptr<FilterHandle>& filter)
     {
-        for(const auto& src : m_sources)
-            src->setDirectFilter(filter);
+        if( m_voiceManager != nullptr )
+            m_voiceManager->setDirectFilter(filter);
     }
 
 private:
     ALCdevice* m_device = nullptr;
     ALCcontext* m_context = nullptr;
     std::shared_ptr<FilterHandle> m_underwaterFilter = nullptr;
-    std::set<std::shared_ptr<SourceHandle>> m_sources;
+    //! Needs the context for creating its sources; @c nullptr if there's no audio device
+    std::unique_ptr<VoiceManager> m_voiceManager;
+    glm::vec3 m_listenerPosition{0, 0, 0};
+
+    mutable std::mutex m_streamsMutex;
     std::set<std::shared_ptr<Stream>> m_streams;
+    std::vector<std::shared_ptr<Stream>> m_retiredStreams;
+    //! Only used by the updater thread, to update the streams without holding the lock
+    std::vector<std::shared_ptr<Stream>> m_updatedStreams;
     std::thread m_streamUpdater;
-    bool m_shutdown = false;
+    std::atomic<bool> m_shutdown{false};
 
     void updateStreams()
     {
-        for(const auto& stream : m_streams)
+        std::vector<std::shared_ptr<Stream>> retired;
+        {
+            std::lock_guard<std::mutex> lock{m_streamsMutex};
+            m_updatedStreams.assign(m_streams.begin(), m_streams.end());
+            // released outside the lock, as destroying a stream joins its decoder
+            retired.swap(m_retiredStreams);
+        }
+
+        for( const auto& stream : m_updatedStreams )
             stream->update();
+
+        m_updatedStreams.clear();
     }
 };
 
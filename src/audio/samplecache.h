@@ -0,0 +1,136 @@
+#pragma once
+
+#include "bufferhandle.h"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace audio
+{
+    /**
+     * @brief Keeps decoded sample buffers around so that re-triggered sounds don't need to be decoded again.
+     *
+     * Buffers are decoded lazily on first use and shared between all sources playing the same sample.
+     * When the decoded size exceeds the configured limit, the least recently used buffers which are not
+     * attached to a source any more are released.
+     */
+    class SampleCache final : public boost::noncopyable
+    {
+    public:
+        static constexpr size_t DefaultMaxSize = 64 * 1024 * 1024;
+
+        explicit SampleCache(size_t maxSize = DefaultMaxSize)
+            : m_maxSize(maxSize)
+        {
+        }
+
+        ~SampleCache()
+        {
+            BOOST_LOG_TRIVIAL(info) << "Sample cache: " << m_hits << " hits, " << m_misses << " misses, "
+                                    << m_evictions << " evictions, " << m_size << " bytes in use";
+        }
+
+        /**
+         * @brief Returns the buffer for a sample, decoding it if it's not cached yet.
+         * @param[in] id Sample index, used as the cache key.
+         * @param[in] wavData The RIFF data of the sample.
+         */
+        std::shared_ptr<BufferHandle> get(size_t id, const uint8_t* wavData)
+        {
+            auto it = m_entries.find(id);
+            if( it != m_entries.end() )
+            {
+                ++m_hits;
+                m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+                return it->second.buffer;
+            }
+
+            ++m_misses;
+
+            auto buffer = std::make_shared<BufferHandle>();
+            if( !buffer->fillFromWav(wavData) )
+                return buffer;
+
+            const auto size = buffer->getSize();
+            m_lru.push_front(id);
+            m_entries.emplace(id, Entry{buffer, size, m_lru.begin()});
+            m_size += size;
+
+            shrink();
+
+            return buffer;
+        }
+
+        void clear()
+        {
+            m_entries.clear();
+            m_lru.clear();
+            m_size = 0;
+        }
+
+        size_t getHits() const noexcept
+        {
+            return m_hits;
+        }
+
+        size_t getMisses() const noexcept
+        {
+            return m_misses;
+        }
+
+        size_t getEvictions() const noexcept
+        {
+            return m_evictions;
+        }
+
+        size_t getSize() const noexcept
+        {
+            return m_size;
+        }
+
+        size_t getMaxSize() const noexcept
+        {
+            return m_maxSize;
+        }
+
+    private:
+        struct Entry
+        {
+            std::shared_ptr<BufferHandle> buffer;
+            size_t size;
+            std::list<size_t>::iterator lruPosition;
+        };
+
+        const size_t m_maxSize;
+        size_t m_size = 0;
+        std::unordered_map<size_t, Entry> m_entries;
+        //! Most recently used sample first
+        std::list<size_t> m_lru;
+
+        size_t m_hits = 0;
+        size_t m_misses = 0;
+        size_t m_evictions = 0;
+
+        void shrink()
+        {
+            auto it = m_lru.end();
+            while( m_size > m_maxSize && it != m_lru.begin() )
+            {
+                --it;
+
+                auto entry = m_entries.find(*it);
+                BOOST_ASSERT(entry != m_entries.end());
+
+                // buffers still attached to a source can't be released by OpenAL
+                if( entry->second.buffer.use_count() > 1 )
+                    continue;
+
+                m_size -= entry->second.size;
+                m_entries.erase(entry);
+                it = m_lru.erase(it);
+                ++m_evictions;
+            }
+        }
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <boost/assert.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <gsl/gsl>
+
+#include <atomic>
+#include <vector>
+
+namespace audio
+{
+    /**
+     * @brief Lock-free single-producer/single-consumer ring of decoded sample chunks.
+     *
+     * The producer fills the chunk returned by beginWrite() and publishes it with endWrite(); the consumer
+     * processes the chunk returned by beginRead() and releases it with endRead().  All chunk memory is
+     * allocated up-front, so streaming doesn't allocate on either side.
+     */
+    class SampleRing final : public boost::noncopyable
+    {
+    public:
+        struct Chunk
+        {
+            std::vector<int16_t> samples;
+            //! Number of valid stereo frames in samples
+            size_t frames = 0;
+            int sampleRate = 0;
+        };
+
+
+        SampleRing(size_t capacity, size_t samplesPerChunk)
+            // one slot always stays unused to distinguish a full ring from an empty one
+            : m_chunks(capacity + 1)
+        {
+            Expects(capacity > 0);
+
+            for( auto& chunk : m_chunks )
+                chunk.samples.resize(samplesPerChunk);
+        }
+
+
+        //! Producer side; returns @c nullptr if the ring is full.
+        Chunk* beginWrite()
+        {
+            const auto head = m_head.load(std::memory_order_relaxed);
+            if( next(head) == m_tail.load(std::memory_order_acquire) )
+                return nullptr;
+
+            return &m_chunks[head];
+        }
+
+
+        void endWrite()
+        {
+            const auto head = m_head.load(std::memory_order_relaxed);
+            BOOST_ASSERT(next(head) != m_tail.load(std::memory_order_acquire));
+            m_head.store(next(head), std::memory_order_release);
+        }
+
+
+        //! Consumer side; returns @c nullptr if the ring is empty.
+        const Chunk* beginRead() const
+        {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            if( tail == m_head.load(std::memory_order_acquire) )
+                return nullptr;
+
+            return &m_chunks[tail];
+        }
+
+
+        void endRead()
+        {
+            const auto tail = m_tail.load(std::memory_order_relaxed);
+            BOOST_ASSERT(tail != m_head.load(std::memory_order_acquire));
+            m_tail.store(next(tail), std::memory_order_release);
+        }
+
+
+        bool isFull() const
+        {
+            return next(m_head.load(std::memory_order_acquire)) == m_tail.load(std::memory_order_acquire);
+        }
+
+
+        size_t getCapacity() const noexcept
+        {
+            return m_chunks.size() - 1;
+        }
+
+    private:
+        std::vector<Chunk> m_chunks;
+        //! Next chunk to be written, owned by the producer
+        std::atomic<size_t> m_head{0};
+        //! Next chunk to be read, owned by the consumer
+        std::atomic<size_t> m_tail{0};
+
+
+        size_t next(size_t idx) const noexcept
+        {
+            return (idx + 1) % m_chunks.size();
+        }
+    };
+}
@@ -54,6 +54,13 @@ namespace audio
             DEBUG_CHECK_AL_ERROR();
         }
 
+        void clearBuffer()
+        {
+            m_buffer.reset();
+            alSourcei(m_handle, AL_BUFFER, 0);
+            DEBUG_CHECK_AL_ERROR();
+        }
+
         const std::shared_ptr<BufferHandle>& getBuffer() const noexcept
         {
             return m_buffer;
@@ -146,21 +153,4 @@ namespace audio
             set(AL_PITCH, util::clamp(pitch_value, 0.5f, 2.0f));
         }
     };
-
-    struct WeakSourceHandleLessComparator
-    {
-        bool operator()(const std::weak_ptr<SourceHandle>& lhs, const std::weak_ptr<SourceHandle>& rhs) const
-        {
-            if(lhs.expired() != rhs.expired())
-                return lhs.expired() < rhs.expired();
-
-            if(lhs.expired())
-            {
-                Expects(rhs.expired());
-                return false;
-            }
-
-            return lhs.lock() < rhs.lock();
-        }
-    };
 }
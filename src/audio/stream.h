@@ -1,25 +1,65 @@
 #pragma once
 
+#include "bufferhandle.h"
+#include "samplering.h"
+#include "sourcehandle.h"
 #include "streamsource.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
 namespace audio
 {
+    /**
+     * @brief Plays a stream source through a queue of OpenAL buffers.
+     *
+     * The source is opened and decoded on a worker thread, which keeps a SampleRing of decoded chunks
+     * filled ahead of playback.  update() only moves decoded chunks into free OpenAL buffers, so neither
+     * opening the source nor a slow decode blocks the caller.  update() must always be called from the
+     * same thread.
+     */
     class Stream : public boost::noncopyable
     {
-    private:
-        std::unique_ptr<AbstractStreamSource> m_stream;
-        SourceHandle m_source;
-        BufferHandle m_buffers[2];
-        std::vector<int16_t> m_sampleBuffer;
-
     public:
-        explicit Stream(std::unique_ptr<AbstractStreamSource>&& src, size_t bufferSize)
-            : m_stream(std::move(src))
-            , m_sampleBuffer(bufferSize * 2)
+        using SourceFactory = std::function<std::unique_ptr<AbstractStreamSource>()>;
+
+        static constexpr size_t DefaultBufferCount = 4;
+
+        /**
+         * @param[in] sourceFactory Opens the stream source; called on the decoder thread.
+         * @param[in] bufferSize Number of frames per buffer.
+         * @param[in] bufferCount Number of OpenAL buffers; the same number of chunks is decoded ahead.
+         */
+        explicit Stream(SourceFactory&& sourceFactory, size_t bufferSize, size_t bufferCount = DefaultBufferCount)
+            : m_ring{bufferCount, bufferSize * 2}
+            , m_buffers(bufferCount)
         {
-            init();
+            Expects(bufferSize > 0 && bufferCount > 0);
 
-            m_source.play();
+            for( const auto& buffer : m_buffers )
+                m_freeBuffers.emplace_back(buffer.get());
+
+            m_decoder = std::thread{
+                [this, factory = std::move(sourceFactory), bufferSize]()
+                {
+                    decode(factory, bufferSize);
+                }
+            };
+        }
+
+        ~Stream()
+        {
+            m_stopDecoder = true;
+            notifyDecoder();
+            m_decoder.join();
+
+            // queued buffers can't be deleted
+            m_source.stop();
+            m_source.set(AL_BUFFER, 0);
         }
 
         void update()
@@ -27,30 +67,60 @@ namespace audio
             ALint processed = 0;
             alGetSourcei(m_source.get(), AL_BUFFERS_PROCESSED, &processed);
             DEBUG_CHECK_AL_ERROR();
-            if( processed == 0 )
-                return;
-
-            ALuint bufId;
-            alSourceUnqueueBuffers(m_source.get(), 1, &bufId);
-            DEBUG_CHECK_AL_ERROR();
 
-            if(bufId == m_buffers[0].get())
+            for( ; processed > 0; --processed )
             {
-                fillBuffer(m_buffers[0]);
+                ALuint bufId;
+                alSourceUnqueueBuffers(m_source.get(), 1, &bufId);
+                DEBUG_CHECK_AL_ERROR();
+                m_freeBuffers.emplace_back(bufId);
             }
-            else if(bufId == m_buffers[1].get())
+
+            while( !m_freeBuffers.empty() )
             {
-                fillBuffer(m_buffers[1]);
+                const SampleRing::Chunk* chunk = m_ring.beginRead();
+                if( chunk == nullptr )
+                    break;
+
+                const auto bufId = m_freeBuffers.back();
+                auto buffer = std::find_if(m_buffers.begin(), m_buffers.end(), [bufId](const BufferHandle& b)
+                                           {
+                                               return b.get() == bufId;
+                                           });
+                if( buffer == m_buffers.end() )
+                {
+                    BOOST_LOG_TRIVIAL(error) << "Stream buffer torn, dropping buffer " << bufId;
+                    m_freeBuffers.pop_back();
+                    continue;
+                }
+
+                buffer->fill(chunk->samples.data(), chunk->frames * 2, 2, chunk->sampleRate);
+                m_ring.endRead();
+                notifyDecoder();
+
+                alSourceQueueBuffers(m_source.get(), 1, &bufId);
+                DEBUG_CHECK_AL_ERROR();
+                m_freeBuffers.pop_back();
             }
-            else
-            {
-                BOOST_LOG_TRIVIAL(error) << "Stream buffer torn, re-init";
-                init();
+
+            if( m_freeBuffers.size() == m_buffers.size() )
                 return;
-            }
 
-            alSourceQueueBuffers(m_source.get(), 1, &bufId);
+            ALint state = AL_STOPPED;
+            alGetSourcei(m_source.get(), AL_SOURCE_STATE, &state);
             DEBUG_CHECK_AL_ERROR();
+            if( state == AL_PLAYING )
+                return;
+
+            // a source stops when it runs out of queued buffers
+            if( m_started )
+            {
+                ++m_underruns;
+                BOOST_LOG_TRIVIAL(warning) << "Stream underrun #" << m_underruns << ", restarting playback";
+            }
+
+            m_source.play();
+            m_started = true;
         }
 
         const SourceHandle& getSource() const noexcept
@@ -63,25 +133,72 @@ namespace audio
             return m_source;
         }
 
-    private:
-        void init()
+        //! Number of times playback ran out of decoded data
+        size_t getUnderruns() const noexcept
         {
-            fillBuffer(m_buffers[0]);
-            fillBuffer(m_buffers[1]);
+            return m_underruns;
+        }
 
-            auto tmp = m_buffers[0].get();
-            alSourceQueueBuffers(m_source.get(), 1, &tmp);
-            DEBUG_CHECK_AL_ERROR();
-            tmp = m_buffers[1].get();
-            alSourceQueueBuffers(m_source.get(), 1, &tmp);
-            DEBUG_CHECK_AL_ERROR();
+        size_t getBufferCount() const noexcept
+        {
+            return m_buffers.size();
+        }
+
+    private:
+        SourceHandle m_source;
+        SampleRing m_ring;
+        std::vector<BufferHandle> m_buffers;
+        //! Buffers not queued on the source, owned by the thread calling update()
+        std::vector<ALuint> m_freeBuffers;
+        bool m_started = false;
+        std::atomic<size_t> m_underruns{0};
+
+        std::atomic<bool> m_stopDecoder{false};
+        std::mutex m_decoderMutex;
+        std::condition_variable m_decoderCondition;
+        std::thread m_decoder;
+
+
+        void notifyDecoder()
+        {
+            // taking the lock ensures the decoder either sees the new state or is already waiting
+            {
+                std::lock_guard<std::mutex> lock{m_decoderMutex};
+            }
+            m_decoderCondition.notify_one();
         }
 
 
-        void fillBuffer(BufferHandle& buffer)
+        void decode(const SourceFactory& factory, size_t frameCount)
         {
-            const auto framesRead = m_stream->readStereo(m_sampleBuffer.data(), m_sampleBuffer.size() / 2);
-            buffer.fill(m_sampleBuffer.data(), framesRead * 2, 2, m_stream->getSampleRate());
+            std::unique_ptr<AbstractStreamSource> source;
+            try
+            {
+                source = factory();
+            }
+            catch( const std::exception& ex )
+            {
+                BOOST_LOG_TRIVIAL(error) << "Failed to open stream: " << ex.what();
+                return;
+            }
+
+            while( !m_stopDecoder )
+            {
+                SampleRing::Chunk* chunk = m_ring.beginWrite();
+                if( chunk == nullptr )
+                {
+                    std::unique_lock<std::mutex> lock{m_decoderMutex};
+                    m_decoderCondition.wait(lock, [this]()
+                                            {
+                                                return m_stopDecoder || !m_ring.isFull();
+                                            });
+                    continue;
+                }
+
+                chunk->frames = source->readStereo(chunk->samples.data(), frameCount);
+                chunk->sampleRate = source->getSampleRate();
+                m_ring.endWrite();
+            }
         }
     };
 }
@@ -0,0 +1,258 @@
+#pragma once
+
+#include "sourcehandle.h"
+
+#include <boost/optional.hpp>
+
+#include <chrono>
+#include <cmath>
+
+
+namespace audio
+{
+    class VoiceManager;
+
+    /**
+     * @brief A playing sound which is not tied to a specific OpenAL source.
+     *
+     * The VoiceManager attaches a pooled source to a voice while it is audible enough to get one.
+     * Otherwise the voice is virtual: it keeps track of its playback position, so that it can continue at
+     * the right offset when it gets a source again.  All setters may be called regardless of whether
+     * the voice currently has a source.
+     */
+    class Voice final : public boost::noncopyable
+    {
+        friend class VoiceManager;
+
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit Voice(const gsl::not_null<std::shared_ptr<BufferHandle>>& buffer, float priority = 1, float maxDistance = 8 * 1024)
+            : m_buffer{buffer}
+            , m_duration{buffer->getDuration()}
+            , m_priority{priority}
+            , m_maxDistance{maxDistance}
+        {
+        }
+
+        ~Voice()
+        {
+            BOOST_ASSERT(m_source == nullptr);
+        }
+
+        //! Starts playback from the beginning, also if the voice is already playing.
+        void play()
+        {
+            m_playing = true;
+            m_offset = 0;
+            m_virtualSince = Clock::now();
+
+            if( m_source != nullptr )
+            {
+                m_source->play();
+                m_sourceStarted = true;
+            }
+        }
+
+        void stop()
+        {
+            m_playing = false;
+
+            if( m_source != nullptr )
+                m_source->stop();
+        }
+
+        bool isStopped() const noexcept
+        {
+            return !m_playing;
+        }
+
+        //! Whether the voice is currently played by an OpenAL source.
+        bool isVirtual() const noexcept
+        {
+            return m_source == nullptr;
+        }
+
+        void setLooping(bool looping)
+        {
+            m_looping = looping;
+
+            if( m_source != nullptr )
+                m_source->setLooping(looping);
+        }
+
+        void setGain(float gain)
+        {
+            m_gain = util::clamp(gain, 0.0f, 1.0f);
+
+            if( m_source != nullptr )
+                m_source->setGain(m_gain);
+        }
+
+        void setPitch(float pitch)
+        {
+            m_pitch = util::clamp(pitch, 0.5f, 2.0f);
+
+            if( m_source != nullptr )
+                m_source->setPitch(m_pitch);
+        }
+
+        //! Voices without a position are played relative to the listener.
+        void setPosition(const boost::optional<glm::vec3>& position)
+        {
+            m_position = position;
+
+            if( m_source != nullptr )
+                applyPosition();
+        }
+
+        const boost::optional<glm::vec3>& getPosition() const noexcept
+        {
+            return m_position;
+        }
+
+        void setDirectFilter(const std::shared_ptr<FilterHandle>& filter)
+        {
+            m_directFilter = filter;
+
+            if( m_source != nullptr )
+                m_source->setDirectFilter(filter);
+        }
+
+        /**
+         * @brief How important it is to play this voice for a listener at the given position.
+         *
+         * Used to decide which voices get a source; a result of zero means the voice is inaudible.
+         */
+        float getAudibility(const glm::vec3& listenerPosition) const
+        {
+            if( !m_playing )
+                return 0;
+
+            if( !m_position )
+                return m_priority * m_gain;
+
+            const auto distance = glm::distance(*m_position, listenerPosition);
+            if( distance >= m_maxDistance )
+                return 0;
+
+            // matches the attenuation of AL_LINEAR_DISTANCE_CLAMPED
+            return m_priority * m_gain * (1 - distance / m_maxDistance);
+        }
+
+    private:
+        const std::shared_ptr<BufferHandle> m_buffer;
+        const float m_duration;
+        const float m_priority;
+        const float m_maxDistance;
+
+        float m_gain = 1;
+        float m_pitch = 1;
+        bool m_looping = false;
+        boost::optional<glm::vec3> m_position;
+        std::shared_ptr<FilterHandle> m_directFilter;
+
+        bool m_playing = false;
+        //! Playback position in seconds when the voice lost its source
+        float m_offset = 0;
+        Clock::time_point m_virtualSince = Clock::now();
+
+        //! Pooled source owned by the VoiceManager
+        SourceHandle* m_source = nullptr;
+        //! A source reports AL_INITIAL until it is started, which must not be mistaken for having finished
+        bool m_sourceStarted = false;
+
+
+        void applyPosition()
+        {
+            if( m_position )
+            {
+                m_source->set(AL_SOURCE_RELATIVE, AL_FALSE);
+                m_source->setPosition(*m_position);
+            }
+            else
+            {
+                m_source->set(AL_SOURCE_RELATIVE, AL_TRUE);
+                m_source->setPosition({0, 0, 0});
+            }
+        }
+
+
+        //! Playback position a virtual voice would have reached by now.
+        float getVirtualOffset(const Clock::time_point& now) const
+        {
+            const auto elapsed = std::chrono::duration<float>(now - m_virtualSince).count();
+            const auto offset = m_offset + elapsed * m_pitch;
+
+            if( m_looping && m_duration > 0 )
+                return std::fmod(offset, m_duration);
+
+            return offset;
+        }
+
+
+        //! Updates the playback state; called by the VoiceManager once per update.
+        void updateState(const Clock::time_point& now)
+        {
+            if( !m_playing )
+                return;
+
+            if( m_source != nullptr )
+            {
+                ALint state = AL_STOPPED;
+                alGetSourcei(m_source->get(), AL_SOURCE_STATE, &state);
+                DEBUG_CHECK_AL_ERROR();
+
+                if( m_sourceStarted && state == AL_STOPPED )
+                    m_playing = false;
+            }
+            else if( !m_looping && getVirtualOffset(now) >= m_duration )
+            {
+                m_playing = false;
+            }
+        }
+
+
+        void attach(SourceHandle& source, const Clock::time_point& now)
+        {
+            BOOST_ASSERT(m_source == nullptr);
+            BOOST_ASSERT(m_playing);
+
+            m_source = &source;
+            m_source->setBuffer(m_buffer);
+            m_source->setLooping(m_looping);
+            m_source->setGain(m_gain);
+            m_source->setPitch(m_pitch);
+            m_source->set(AL_MAX_DISTANCE, m_maxDistance);
+            m_source->setDirectFilter(m_directFilter);
+            applyPosition();
+
+            m_source->set(AL_SEC_OFFSET, getVirtualOffset(now));
+            m_source->play();
+            m_sourceStarted = true;
+        }
+
+
+        SourceHandle& detach(const Clock::time_point& now)
+        {
+            BOOST_ASSERT(m_source != nullptr);
+
+            ALfloat offset = 0;
+            alGetSourcef(m_source->get(), AL_SEC_OFFSET, &offset);
+            DEBUG_CHECK_AL_ERROR();
+
+            m_offset = offset;
+            m_virtualSince = now;
+
+            auto& source = *m_source;
+            source.stop();
+            // releases the buffer, so that the sample cache may evict it
+            source.clearBuffer();
+            source.setDirectFilter(nullptr);
+
+            m_source = nullptr;
+            m_sourceStarted = false;
+            return source;
+        }
+    };
+}
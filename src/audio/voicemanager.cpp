@@ -0,0 +1,131 @@
+#include "voicemanager.h"
+
+#include <algorithm>
+
+
+namespace audio
+{
+    namespace
+    {
+        // A voice keeps its source unless a competitor is clearly more audible, so that voices of
+        // similar audibility don't keep stealing each other's sources.
+        constexpr float AttachedVoiceBias = 1.25f;
+    }
+
+
+    VoiceManager::VoiceManager(size_t sourceCount)
+    {
+        Expects(sourceCount > 0);
+
+        m_sources.reserve(sourceCount);
+        m_freeSources.reserve(sourceCount);
+        for( size_t i = 0; i < sourceCount; ++i )
+        {
+            m_sources.emplace_back(std::make_unique<SourceHandle>());
+            m_freeSources.emplace_back(m_sources.back().get());
+        }
+    }
+
+
+    VoiceManager::~VoiceManager()
+    {
+        BOOST_LOG_TRIVIAL(info) << "Voice manager: " << m_virtualisations << " virtualisations, "
+                                << m_voices.size() << " voices left";
+
+        clear();
+    }
+
+
+    void VoiceManager::add(const gsl::not_null<std::shared_ptr<Voice>>& voice)
+    {
+        m_voices.emplace_back(voice);
+
+        if( m_freeSources.empty() || voice->isStopped() || voice->getAudibility(m_listenerPosition) <= 0 )
+            return;
+
+        voice->attach(*m_freeSources.back(), Voice::Clock::now());
+        m_freeSources.pop_back();
+    }
+
+
+    void VoiceManager::update(const glm::vec3& listenerPosition)
+    {
+        m_listenerPosition = listenerPosition;
+        const auto now = Voice::Clock::now();
+
+        for( const auto& voice : m_voices )
+        {
+            voice->updateState(now);
+            if( voice->isStopped() && !voice->isVirtual() )
+                release(*voice, now);
+        }
+
+        m_voices.erase(std::remove_if(m_voices.begin(), m_voices.end(), [](const std::shared_ptr<Voice>& voice)
+                                      {
+                                          return voice->isStopped();
+                                      }), m_voices.end());
+
+        m_ranking.clear();
+        for( const auto& voice : m_voices )
+        {
+            auto audibility = voice->getAudibility(listenerPosition);
+            if( !voice->isVirtual() )
+                audibility *= AttachedVoiceBias;
+
+            m_ranking.emplace_back(audibility, voice.get());
+        }
+
+        std::sort(m_ranking.begin(), m_ranking.end(), [](const std::pair<float, Voice*>& a, const std::pair<float, Voice*>& b)
+                  {
+                      return a.first > b.first;
+                  });
+
+        // release the sources of voices that don't make it into the pool first, so that they can be re-used below
+        for( size_t i = 0; i < m_ranking.size(); ++i )
+        {
+            Voice& voice = *m_ranking[i].second;
+            if( voice.isVirtual() )
+                continue;
+
+            if( i >= m_sources.size() || m_ranking[i].first <= 0 )
+            {
+                release(voice, now);
+                ++m_virtualisations;
+            }
+        }
+
+        for( size_t i = 0; i < m_ranking.size() && i < m_sources.size(); ++i )
+        {
+            if( m_ranking[i].first <= 0 )
+                break;
+
+            Voice& voice = *m_ranking[i].second;
+            if( !voice.isVirtual() )
+                continue;
+
+            BOOST_ASSERT(!m_freeSources.empty());
+            voice.attach(*m_freeSources.back(), now);
+            m_freeSources.pop_back();
+        }
+    }
+
+
+    void VoiceManager::clear()
+    {
+        const auto now = Voice::Clock::now();
+        for( const auto& voice : m_voices )
+        {
+            voice->stop();
+            if( !voice->isVirtual() )
+                release(*voice, now);
+        }
+
+        m_voices.clear();
+    }
+
+
+    void VoiceManager::release(Voice& voice, const Voice::Clock::time_point& now)
+    {
+        m_freeSources.emplace_back(&voice.detach(now));
+    }
+}
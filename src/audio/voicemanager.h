@@ -0,0 +1,78 @@
+#pragma once
+
+#include "voice.h"
+
+#include <vector>
+
+
+namespace audio
+{
+    /**
+     * @brief Plays voices through a fixed pool of OpenAL sources.
+     *
+     * Each update ranks the playing voices by their audibility for the listener; the most audible ones
+     * are played by the pooled sources, all others are virtualised until they become audible enough
+     * again.  Finished voices are dropped.  Neither playing nor updating allocates OpenAL objects.
+     */
+    class VoiceManager final : public boost::noncopyable
+    {
+    public:
+        static constexpr size_t DefaultSourceCount = 32;
+
+        explicit VoiceManager(size_t sourceCount = DefaultSourceCount);
+
+        ~VoiceManager();
+
+        /**
+         * @brief Starts managing a voice.
+         *
+         * If a source is free, it is attached immediately, so that short sounds don't miss their start;
+         * otherwise the voice competes for a source at the next update().
+         */
+        void add(const gsl::not_null<std::shared_ptr<Voice>>& voice);
+
+        void update(const glm::vec3& listenerPosition);
+
+        //! Stops and drops all voices.
+        void clear();
+
+        void setDirectFilter(const std::shared_ptr<FilterHandle>& filter)
+        {
+            for( const auto& voice : m_voices )
+                voice->setDirectFilter(filter);
+        }
+
+        size_t getVoiceCount() const noexcept
+        {
+            return m_voices.size();
+        }
+
+        size_t getSourceCount() const noexcept
+        {
+            return m_sources.size();
+        }
+
+        //! Number of voices currently played by a source
+        size_t getAudibleVoiceCount() const noexcept
+        {
+            return m_sources.size() - m_freeSources.size();
+        }
+
+        //! Total number of times a voice lost its source
+        size_t getVirtualisations() const noexcept
+        {
+            return m_virtualisations;
+        }
+
+    private:
+        std::vector<std::unique_ptr<SourceHandle>> m_sources;
+        std::vector<SourceHandle*> m_freeSources;
+        std::vector<std::shared_ptr<Voice>> m_voices;
+        //! Re-used by update() to avoid allocations
+        std::vector<std::pair<float, Voice*>> m_ranking;
+        glm::vec3 m_listenerPosition{0, 0, 0};
+        size_t m_virtualisations = 0;
+
+        void release(Voice& voice, const Voice::Clock::time_point& now);
+    };
+}
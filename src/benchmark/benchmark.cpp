@@ -0,0 +1,190 @@
+#include "measure.h"
+
+#include "engine/lara/abstractstatehandler.h"
+#include "engine/laranode.h"
+#include "level/level.h"
+#include "level/levelcache.h"
+#include "level/meshtable.h"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+
+std::atomic<size_t> benchmark::allocationCount{0};
+
+
+void* operator new(size_t size)
+{
+    ++benchmark::allocationCount;
+    if( void* ptr = std::malloc(size == 0 ? 1 : size) )
+        return ptr;
+
+    throw std::bad_alloc{};
+}
+
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+
+void operator delete(void* ptr, size_t /*size*/) noexcept
+{
+    std::free(ptr);
+}
+
+
+namespace
+{
+    //! Keeps the compiler from optimizing away the measured code
+    volatile size_t sink = 0;
+
+
+    //! The former Level::readMeshData(), which read one mesh per mesh pointer, including the shared ones
+    template<typename F>
+    void buildMeshTableQuadratic(std::vector<uint32_t>& meshPointers, F&& readMesh)
+    {
+        size_t meshDataPos = 0;
+        for( size_t i = 0; i < meshPointers.size(); i++ )
+        {
+            std::replace(meshPointers.begin(), meshPointers.end(), meshDataPos, i);
+
+            readMesh(gsl::narrow<uint32_t>(meshDataPos));
+
+            for( size_t j = 0; j < meshPointers.size(); j++ )
+            {
+                if( meshPointers[j] > meshDataPos )
+                {
+                    meshDataPos = meshPointers[j];
+                    break;
+                }
+            }
+        }
+    }
+
+
+    /**
+     * @brief A synthetic mesh pointer table, in the size range of the larger TR4/TR5 levels.
+     *
+     * Every distinct mesh is 256 bytes, the first one starts at offset 0, and about a quarter
+     * of the pointers are distinct.  The table is shuffled with a fixed seed to be repeatable.
+     */
+    std::vector<uint32_t> createMeshPointers(size_t count)
+    {
+        std::vector<uint32_t> meshPointers;
+        meshPointers.reserve(count);
+        for( size_t i = 0; i < count; ++i )
+            meshPointers.emplace_back(gsl::narrow<uint32_t>(i / 4 * 256));
+
+        std::shuffle(meshPointers.begin() + 1, meshPointers.end(), std::mt19937{4711});
+        return meshPointers;
+    }
+
+
+    void benchmarkMeshTable(size_t meshPointerCount, size_t iterations)
+    {
+        const auto meshPointers = createMeshPointers(meshPointerCount);
+
+        // reading a mesh is not part of the measurement, only the number of meshes read
+        size_t readMeshes = 0;
+        const auto readMesh = [&readMeshes](uint32_t offset)
+        {
+            sink = offset;
+            ++readMeshes;
+        };
+
+        const auto before = benchmark::measure(iterations, [&]()
+        {
+            auto table = meshPointers;
+            buildMeshTableQuadratic(table, readMesh);
+        });
+        std::cout << readMeshes / iterations << " meshes read for " << meshPointerCount << " mesh pointers before\n";
+        benchmark::report("Mesh table, replace and scan per pointer", before);
+
+        readMeshes = 0;
+        const auto after = benchmark::measure(iterations, [&]()
+        {
+            auto table = meshPointers;
+            level::buildMeshTable(table, readMesh);
+        });
+        std::cout << readMeshes / iterations << " meshes read for " << meshPointerCount << " mesh pointers after\n";
+        benchmark::report("Mesh table, sorted and deduplicated", after);
+        benchmark::reportSpeedup("Mesh table", before, after);
+    }
+
+
+    void benchmarkLaraStateDispatch(engine::LaraNode& lara, size_t iterations)
+    {
+        const auto state = lara.getCurrentAnimState();
+
+        // before, a handler was created on the heap for the input, and another one for the post-processing
+        const auto before = benchmark::measure(iterations, [&]()
+        {
+            const auto input = engine::lara::AbstractStateHandler::create(state, lara);
+            const auto postprocess = engine::lara::AbstractStateHandler::create(state, lara);
+            sink = (input != nullptr) + (postprocess != nullptr);
+        });
+        benchmark::report("Lara state dispatch per tick, created handlers", before);
+
+        const auto after = benchmark::measure(iterations, [&]()
+        {
+            sink = static_cast<size_t>(lara.getStateHandler(state).getId());
+            sink = static_cast<size_t>(lara.getStateHandler(state).getId());
+        });
+        benchmark::report("Lara state dispatch per tick, handler table", after);
+        benchmark::reportSpeedup("Lara state dispatch", before, after);
+    }
+
+
+    void benchmarkLaraUpdate(level::Level& lvl, size_t iterations)
+    {
+        const auto measurement = benchmark::measure(iterations, [&lvl]()
+        {
+            lvl.m_lara->update();
+            lvl.applyScheduledDeletions();
+        });
+        benchmark::report("Lara update per tick", measurement);
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    // the mesh table is synthetic, so it is measured even without a level
+    benchmarkMeshTable(4000, 100);
+
+    if( argc < 2 )
+    {
+        std::cerr << "Usage: " << argv[0] << " [<level file> [iterations]]\n";
+        return EXIT_SUCCESS;
+    }
+
+    const boost::filesystem::path levelFilename{argv[1]};
+    const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 100000;
+
+    gameplay::Game* game = new gameplay::Game();
+    game->run();
+
+    auto lvl = level::Level::createLoader(levelFilename.string(), level::Game::Unknown);
+    BOOST_ASSERT(lvl != nullptr);
+    const auto baseName = levelFilename.stem().string();
+    level::LevelCache::load(*lvl, levelFilename, boost::filesystem::path("assets/tr1") / baseName / "_level.cache");
+    lvl->setUpRendering(game, "assets/tr1", baseName, nullptr, false);
+    if( lvl->m_lara == nullptr )
+    {
+        std::cerr << "The level has no Lara\n";
+        return EXIT_FAILURE;
+    }
+
+    benchmarkLaraStateDispatch(*lvl->m_lara, iterations);
+    // the update runs the whole game logic of Lara, so it is far slower than the other measurements
+    benchmarkLaraUpdate(*lvl, iterations / 100);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+
+
+namespace benchmark
+{
+    //! Counts the calls of the global operator new, which the benchmark executable replaces
+    extern std::atomic<size_t> allocationCount;
+
+
+    struct Measurement
+    {
+        size_t iterations = 0;
+        std::chrono::nanoseconds duration{0};
+        size_t allocations = 0;
+
+
+        double getNanosecondsPerIteration() const
+        {
+            return static_cast<double>(duration.count()) / iterations;
+        }
+
+
+        double getAllocationsPerIteration() const
+        {
+            return static_cast<double>(allocations) / iterations;
+        }
+    };
+
+
+    //! Calls @a f @a iterations times, and records the time taken and the heap allocations made
+    template<typename F>
+    Measurement measure(size_t iterations, F&& f)
+    {
+        Measurement result;
+        result.iterations = iterations;
+
+        const auto allocationsBefore = allocationCount.load();
+        const auto startTime = std::chrono::high_resolution_clock::now();
+        for( size_t i = 0; i < iterations; ++i )
+            f();
+        result.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - startTime);
+        result.allocations = allocationCount.load() - allocationsBefore;
+
+        return result;
+    }
+
+
+    inline void report(const std::string& name, const Measurement& measurement)
+    {
+        std::cout << name << ": " << measurement.getNanosecondsPerIteration() << "ns and "
+                  << measurement.getAllocationsPerIteration() << " allocations per iteration ("
+                  << measurement.iterations << " iterations)\n";
+    }
+
+
+    //! Reports the time of the former implementation of something relative to the current one
+    inline void reportSpeedup(const std::string& name, const Measurement& before, const Measurement& after)
+    {
+        std::cout << name << ": " << before.getNanosecondsPerIteration() / after.getNanosecondsPerIteration()
+                  << "x faster than before\n";
+    }
+}
@@ -1,10 +1,12 @@
 #include "level/level.h"
+#include "level/levelcache.h"
 #include "engine/laranode.h"
 #include "loader/trx/trx.h"
 
 #include "LuaState.h"
 
 #include "gl/framebuffer.h"
+#include "render/frameuniforms.h"
 #include "ext/font.h"
 
 #include <boost/range/adaptors.hpp>
@@ -18,7 +20,7 @@ namespace
     }
 
 
-    void drawDebugInfo(const std::unique_ptr<gameplay::ext::Font>& font, gsl::not_null<level::Level*> lvl, int fps)
+    void drawDebugInfo(const std::unique_ptr<gameplay::ext::Font>& font, gsl::not_null<level::Level*> lvl, int fps, const gameplay::RenderQueue::Statistics& renderStatistics)
     {
         drawText(font, font->getTarget()->getWidth() - 40, font->getTarget()->getHeight() - 20, std::to_string(fps));
 
@@ -34,6 +36,17 @@ namespace
         drawText(font, 300, 100, "grav " + boost::lexical_cast<std::string>(lvl->m_lara->getFallSpeed()));
         drawText(font, 300, 120, "fwd  " + boost::lexical_cast<std::string>(lvl->m_lara->getHorizontalSpeed()));
 
+        // audio
+        drawText(font, 300, 140, "smpl " + boost::lexical_cast<std::string>(lvl->m_sampleCache.getHits()) + "/" + boost::lexical_cast<std::string>(lvl->m_sampleCache.getMisses()));
+
+        // rendering
+        drawText(font, 300, 160, "draw " + boost::lexical_cast<std::string>(renderStatistics.drawCalls)
+                                 + " prog " + boost::lexical_cast<std::string>(renderStatistics.programChanges)
+                                 + " mtl " + boost::lexical_cast<std::string>(renderStatistics.materialBinds)
+                                 + " skip " + boost::lexical_cast<std::string>(renderStatistics.skippedMaterialBinds));
+        drawText(font, 300, 180, "nodes " + boost::lexical_cast<std::string>(lvl->m_cameraController->getCullingStatistics().drawn)
+                                 + " culled " + boost::lexical_cast<std::string>(lvl->m_cameraController->getCullingStatistics().culled));
+
         // animation
         drawText(font, 10, 60, std::string("current/anim    ") + loader::toString(lvl->m_lara->getCurrentAnimState()));
         drawText(font, 10, 100, std::string("target          ") + loader::toString(lvl->m_lara->getTargetState()));
@@ -116,7 +129,6 @@ public:
         if(auto tmp = part->getMaterial()->getParameter("u_depth"))
             tmp->set(m_depthBuffer);
         part->getMaterial()->getParameter("u_projectionMatrix")->set(glm::ortho(vp.x, vp.width, vp.height, vp.y, 0.0f, 1.0f));
-        part->getMaterial()->getParameter("u_projection")->bind(game->getScene()->getActiveCamera().get(), &gameplay::Camera::getProjectionMatrix);
         if(auto tmp = part->getMaterial()->getParameter("u_texture"))
             tmp->set(m_colorBuffer);
 
@@ -157,19 +169,10 @@ private:
 
 void update(const std::unique_ptr<level::Level>& lvl)
 {
-    for( const std::shared_ptr<engine::items::ItemNode>& ctrl : lvl->m_itemNodes | boost::adaptors::map_values )
-    {
-        if( ctrl.get() == lvl->m_lara ) // Lara is special and needs to be updated last
-            continue;
-
-        ctrl->update();
-    }
-
-    for( const std::shared_ptr<engine::items::ItemNode>& ctrl : lvl->m_dynamicItems )
-    {
-        ctrl->update();
-    }
+    if( lvl->m_aiScheduler != nullptr )
+        lvl->m_aiScheduler->prepare();
 
+    lvl->updateItems();
     lvl->m_lara->update();
 
     lvl->applyScheduledDeletions();
@@ -185,10 +188,11 @@ int main()
     mainScript.doFile("scripts/main.lua");
     lua::Value levelInfo = mainScript["getLevelInfo"].call();
 
-    auto lvl = level::Level::createLoader("data/tr1/data/" + levelInfo["baseName"].toString() + ".PHD", level::Game::Unknown);
+    const std::string levelFilename = "data/tr1/data/" + levelInfo["baseName"].toString() + ".PHD";
+    auto lvl = level::Level::createLoader(levelFilename, level::Game::Unknown);
 
     BOOST_ASSERT(lvl != nullptr);
-    lvl->loadFileData();
+    level::LevelCache::load(*lvl, levelFilename, boost::filesystem::path("assets/tr1") / levelInfo["baseName"].toString() / "_level.cache");
 
     const auto glidosPack = mainScript["getGlidosPack"].call();
 
@@ -199,7 +203,10 @@ int main()
         glidos->dump();
     }
 
-    lvl->setUpRendering(game, "assets/tr1", levelInfo["baseName"].toString(), glidos);
+    const auto exportAssets = mainScript["getExportAssets"].call();
+
+    lvl->setUpRendering(game, "assets/tr1", levelInfo["baseName"].toString(), glidos,
+                        exportAssets.isNil() || exportAssets.toBool());
 
     if( !levelInfo["swapRooms"].isNil() && levelInfo["swapRooms"].toBool() )
     {
@@ -223,13 +230,8 @@ int main()
     FullScreenFX depthDarknessWaterFx{game, gameplay::ShaderProgram::createFromFile("shaders/fx_darkness.vert", "shaders/fx_darkness.frag", {"WATER", "LENS_DISTORTION"}), gsl::narrow<GLint>(game->getMultiSampling())};
     depthDarknessWaterFx.getMaterial()->getParameter("aspect_ratio")->set(1.6f);
     depthDarknessWaterFx.getMaterial()->getParameter("distortion_power")->set(-2.0f);
-    depthDarknessWaterFx.getMaterial()->getParameter("u_time")->bind(
-                            [game](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
-                            {
-                                const auto now = std::chrono::time_point_cast<std::chrono::milliseconds>(game->getGameTime());
-                                uniform.set(gsl::narrow_cast<float>(now.time_since_epoch().count()));
-                            }
-                        );
+
+    render::FrameUniforms frameUniforms;
 
     static const auto frameTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::seconds(1)) / core::FrameRate;
 
@@ -275,6 +277,10 @@ int main()
 
         lvl->drawBars(game, screenOverlay->getImage());
 
+        frameUniforms.update(*game->getScene()->getActiveCamera(), game->getGameTime(),
+                             lvl->m_cameraController->getCurrentRoom()->isWaterRoom());
+        lvl->m_itemLighting->update();
+
 #define WITH_POSTFX
 
 #ifdef WITH_POSTFX
@@ -300,7 +306,7 @@ int main()
 #endif
 
         if(showDebugInfo)
-            drawDebugInfo(font, lvl.get(), game->getFrameRate());
+            drawDebugInfo(font, lvl.get(), game->getFrameRate(), game->getRenderQueue().getStatistics());
 
         for( const std::shared_ptr<engine::items::ItemNode>& ctrl : lvl->m_itemNodes | boost::adaptors::map_values )
         {
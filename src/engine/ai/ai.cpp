@@ -224,147 +224,60 @@ namespace engine
             path.clear();
             searchTarget = enemy.getPosition();
 
-            BOOST_ASSERT(enemy.getCurrentBox().is_initialized());
-
-            const auto startBox = *npc.getCurrentBox() & ~0xc000;
-            destinationBox = *enemy.getCurrentBox() & ~0xc000;
-
-            static constexpr const uint16_t maxDepth = 5;
-            static constexpr const int UnsetBoxId = -1;
-
-            std::vector<int> parents;
-
-            std::vector<uint16_t> levelNodes;
-            std::vector<uint16_t> nextLevel;
-            levelNodes.emplace_back(startBox);
-
-            std::vector<int> costs(startBox+1, UnsetBoxId);
-            costs[startBox] = 0;
-
-            for( uint16_t level = 1; level <= maxDepth; ++level )
-            {
-                nextLevel.clear();
-
-                for( const auto levelBoxIdx : levelNodes )
-                {
-                    BOOST_ASSERT(levelBoxIdx < npc.getLevel().m_boxes.size());
-                    const auto& levelBox = npc.getLevel().m_boxes[levelBoxIdx];
-                    const uint16_t overlapIdx = static_cast<uint16_t>( levelBox.overlap_index & ~0xc000 );
-                    // examine edge levelBox --> childBox
-                    for( auto childBox : getOverlaps(npc.getLevel(), overlapIdx) )
-                    {
-                        BOOST_ASSERT(childBox != levelBoxIdx);
-                        if( !canTravelFromTo(npc.getLevel(), levelBoxIdx, childBox) )
-                        {
-                            continue;
-                        }
-
-                        if(costs.size() <= childBox)
-                            costs.resize(childBox + 1, UnsetBoxId);
-
-                        const bool unvisited = costs[childBox] == UnsetBoxId;
-
-                        if( unvisited || level < costs[childBox])
-                        {
-                            costs[childBox] = level;
-                            if(parents.size() <= childBox)
-                                parents.resize(childBox+1, UnsetBoxId);
-                            parents[childBox] = levelBoxIdx;
-                        }
-
-                        if( childBox == destinationBox )
-                        {
-                            auto current = *destinationBox;
-                            BOOST_ASSERT(path.empty());
-                            BOOST_ASSERT(current < npc.getLevel().m_boxes.size());
-                            path.push_back(&npc.getLevel().m_boxes[current]);
-                            while(parents.size() > current && parents[current] != UnsetBoxId )
-                            {
-                                current = parents[current];
-                                BOOST_ASSERT(current < npc.getLevel().m_boxes.size());
-                                path.push_back(&npc.getLevel().m_boxes[current]);
-                            }
-
-                            std::reverse(path.begin(), path.end());
-
-                            BOOST_ASSERT(path.front() == &npc.getLevel().m_boxes[startBox]);
-
-                            return;
-                        }
-
-                        if( unvisited )
-                        {
-                            nextLevel.emplace_back(childBox);
-                        }
-                    }
-                }
-
-                levelNodes.swap(nextLevel);
-            }
-
-            BOOST_ASSERT(path.empty());
-        }
-
+            const auto key = getPathKey(npc, enemy);
+            destinationBox = key.to;
 
-        gsl::span<const uint16_t> RoutePlanner::getOverlaps(const level::Level& lvl, uint16_t idx)
-        {
-            const uint16_t* first = &lvl.m_overlaps[idx];
-            const uint16_t* last = first;
-            const uint16_t* const endOfUniverse = &lvl.m_overlaps.back();
+            const auto& lvl = npc.getLevel();
+            BOOST_ASSERT(lvl.m_routeCache != nullptr);
 
-            while( last <= endOfUniverse && (*last & 0x8000) == 0 )
+            for( const auto box : lvl.m_routeCache->getPath(key) )
             {
-                ++last;
+                BOOST_ASSERT(box < lvl.m_boxes.size());
+                path.push_back(&lvl.m_boxes[box]);
             }
-
-            return gsl::span<const uint16_t>(first, last);
         }
 
 
-        bool RoutePlanner::canTravelFromTo(const level::Level& lvl, uint16_t from, uint16_t to) const
+        RouteCache::PathKey RoutePlanner::getPathKey(const items::ItemNode& npc, const items::ItemNode& enemy) const
         {
-            Expects(from < lvl.m_boxes.size());
-            Expects(to < lvl.m_boxes.size());
-
-            const auto& fromBox = lvl.m_boxes[from];
-            const auto& toBox = lvl.m_boxes[to];
-            if( (toBox.overlap_index & blockMask) != 0 )
-            {
-                return false;
-            }
-
-            const auto& zone = getZoneData(lvl);
-
-            BOOST_ASSERT(from < zone.size());
-            BOOST_ASSERT(to < zone.size());
-
-            if( zone[from] != zone[to] )
-            {
-                return false;
-            }
+            BOOST_ASSERT(npc.getCurrentBox().is_initialized());
+            BOOST_ASSERT(enemy.getCurrentBox().is_initialized());
 
-            const auto d = toBox.floor - fromBox.floor;
-            return d >= dropHeight && d <= stepHeight;
+            return RouteCache::PathKey{
+                getZoneType(),
+                npc.getLevel().roomsAreSwapped,
+                blockMask,
+                dropHeight,
+                stepHeight,
+                static_cast<uint16_t>(*npc.getCurrentBox() & ~0xc000),
+                static_cast<uint16_t>(*enemy.getCurrentBox() & ~0xc000)
+            };
         }
 
 
-        const loader::ZoneData& RoutePlanner::getZoneData(const level::Level& lvl) const
+        ZoneType RoutePlanner::getZoneType() const
         {
             if( flyHeight != 0 )
             {
-                return lvl.roomsAreSwapped ? lvl.m_alternateZones.flyZone : lvl.m_baseZones.flyZone;
+                return ZoneType::Fly;
             }
             else if( stepHeight == loader::QuarterSectorSize )
             {
-                return lvl.roomsAreSwapped ? lvl.m_alternateZones.groundZone1 : lvl.m_baseZones.groundZone1;
+                return ZoneType::Ground1;
             }
             else
             {
-                return lvl.roomsAreSwapped ? lvl.m_alternateZones.groundZone2 : lvl.m_baseZones.groundZone2;
+                return ZoneType::Ground2;
             }
         }
 
 
+        const loader::ZoneData& RoutePlanner::getZoneData(const level::Level& lvl) const
+        {
+            return ai::getZoneData(lvl, getZoneType(), lvl.roomsAreSwapped);
+        }
+
+
         void RoutePlanner::setRandomSearchTarget(uint16_t boxIdx, const items::ItemNode& npc)
         {
             setRandomSearchTarget(boxIdx, npc.getLevel().m_boxes[boxIdx & ~0x8000]);
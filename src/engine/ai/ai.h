@@ -1,5 +1,6 @@
 #pragma once
 
+#include "routecache.h"
 #include "engine/items/itemnode.h"
 
 
@@ -92,13 +93,15 @@ namespace engine
             void updateMood(Brain& brain, LookAhead& lookAhead, items::AIAgent& npc, bool ignoreProbabilities, uint16_t attackTargetUpdateProbability);
 
 
+            //! @brief Updates #path to lead from the NPC's box to the enemy's box, using the level's RouteCache.
             void findPath(const items::ItemNode& npc, const items::ItemNode& enemy);
 
 
-            static gsl::span<const uint16_t> getOverlaps(const level::Level& lvl, uint16_t idx);
+            //! @brief The route cache key findPath() uses.
+            RouteCache::PathKey getPathKey(const items::ItemNode& npc, const items::ItemNode& enemy) const;
 
 
-            bool canTravelFromTo(const level::Level& lvl, uint16_t from, uint16_t to) const;
+            ZoneType getZoneType() const;
 
 
             const loader::ZoneData& getZoneData(const level::Level& lvl) const;
@@ -0,0 +1,256 @@
+#include "routecache.h"
+
+#include "level/level.h"
+
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+
+
+namespace engine
+{
+    namespace ai
+    {
+        const loader::ZoneData& getZoneData(const level::Level& lvl, ZoneType zoneType, bool roomsAreSwapped)
+        {
+            const auto& zones = roomsAreSwapped ? lvl.m_alternateZones : lvl.m_baseZones;
+            switch( zoneType )
+            {
+                case ZoneType::Ground1:
+                    return zones.groundZone1;
+                case ZoneType::Ground2:
+                    return zones.groundZone2;
+                case ZoneType::Fly:
+                    return zones.flyZone;
+                default:
+                    BOOST_THROW_EXCEPTION(std::runtime_error("Invalid zone type"));
+            }
+        }
+
+
+        namespace
+        {
+            gsl::span<const uint16_t> getOverlaps(const level::Level& lvl, uint16_t idx)
+            {
+                const uint16_t* first = &lvl.m_overlaps[idx];
+                const uint16_t* last = first;
+                const uint16_t* const endOfUniverse = &lvl.m_overlaps.back();
+
+                while( last <= endOfUniverse && (*last & 0x8000) == 0 )
+                {
+                    ++last;
+                }
+
+                return gsl::span<const uint16_t>(first, last);
+            }
+        }
+
+
+        RouteCache::RouteCache(const level::Level& lvl)
+            : m_level{lvl}
+        {
+            for( const auto zoneType : {ZoneType::Ground1, ZoneType::Ground2, ZoneType::Fly} )
+            {
+                for( const auto roomsAreSwapped : {false, true} )
+                {
+                    const auto& zone = getZoneData(lvl, zoneType, roomsAreSwapped);
+                    auto& graph = m_graphs[getGraphIndex(zoneType, roomsAreSwapped)];
+
+                    graph.offsets.reserve(lvl.m_boxes.size() + 1);
+                    for( size_t from = 0; from < lvl.m_boxes.size(); ++from )
+                    {
+                        graph.offsets.emplace_back(gsl::narrow<uint32_t>(graph.neighbours.size()));
+
+                        const auto overlapIdx = static_cast<uint16_t>(lvl.m_boxes[from].overlap_index & ~0xc000);
+                        for( const auto to : getOverlaps(lvl, overlapIdx) )
+                        {
+                            BOOST_ASSERT(to < lvl.m_boxes.size());
+                            BOOST_ASSERT(from < zone.size() && to < zone.size());
+                            if( zone[from] == zone[to] )
+                                graph.neighbours.emplace_back(to);
+                        }
+                    }
+                    graph.offsets.emplace_back(gsl::narrow<uint32_t>(graph.neighbours.size()));
+                }
+            }
+
+            BOOST_LOG_TRIVIAL(debug) << "Box graph: " << lvl.m_boxes.size() << " boxes, "
+                                     << m_graphs[getGraphIndex(ZoneType::Ground1, false)].neighbours.size() << " ground overlaps";
+        }
+
+
+        RouteCache::~RouteCache()
+        {
+            BOOST_LOG_TRIVIAL(info) << "Route cache: " << m_hits << " hits, " << m_misses << " misses, "
+                                    << m_invalidations << " invalidations";
+        }
+
+
+        gsl::span<const uint16_t> RouteCache::getNeighbours(ZoneType zoneType, bool roomsAreSwapped, uint16_t box) const
+        {
+            const auto& graph = m_graphs[getGraphIndex(zoneType, roomsAreSwapped)];
+            Expects(box + 1u < graph.offsets.size());
+
+            const auto first = graph.neighbours.data() + graph.offsets[box];
+            const auto last = graph.neighbours.data() + graph.offsets[box + 1];
+            return gsl::span<const uint16_t>(first, last);
+        }
+
+
+        const std::vector<uint16_t>& RouteCache::getPath(const PathKey& key) const
+        {
+            Expects(key.from < m_level.m_boxes.size());
+            Expects(key.to < m_level.m_boxes.size());
+
+            auto it = m_paths.find(key);
+            if( it != m_paths.end() )
+            {
+                ++m_hits;
+                return it->second;
+            }
+
+            ++m_misses;
+
+            if( m_paths.size() >= MaxCachedPaths )
+                m_paths.clear();
+
+            auto& path = m_paths[key];
+            searchPath(key, m_searchState, path);
+            return path;
+        }
+
+
+        void RouteCache::storePath(const PathKey& key, std::vector<uint16_t>&& path)
+        {
+            if( m_paths.size() >= MaxCachedPaths )
+                m_paths.clear();
+
+            m_paths[key] = std::move(path);
+        }
+
+
+        void RouteCache::invalidatePaths()
+        {
+            m_paths.clear();
+            ++m_invalidations;
+        }
+
+
+        size_t RouteCache::PathKeyHash::operator()(const PathKey& key) const
+        {
+            size_t seed = 0;
+            boost::hash_combine(seed, static_cast<uint8_t>(key.zoneType));
+            boost::hash_combine(seed, key.roomsAreSwapped);
+            boost::hash_combine(seed, key.blockMask);
+            boost::hash_combine(seed, key.dropHeight);
+            boost::hash_combine(seed, key.stepHeight);
+            boost::hash_combine(seed, key.from);
+            boost::hash_combine(seed, key.to);
+            return seed;
+        }
+
+
+        size_t RouteCache::getGraphIndex(ZoneType zoneType, bool roomsAreSwapped)
+        {
+            return static_cast<size_t>(zoneType) * 2 + (roomsAreSwapped ? 1 : 0);
+        }
+
+
+        bool RouteCache::canTravelFromTo(const PathKey& key, uint16_t from, uint16_t to) const
+        {
+            const auto& fromBox = m_level.m_boxes[from];
+            const auto& toBox = m_level.m_boxes[to];
+            if( (toBox.overlap_index & key.blockMask) != 0 )
+            {
+                return false;
+            }
+
+            // zones are already checked when building the graph
+            const auto d = toBox.floor - fromBox.floor;
+            return d >= key.dropHeight && d <= key.stepHeight;
+        }
+
+
+        void RouteCache::searchPath(const PathKey& key, SearchState& state, std::vector<uint16_t>& path) const
+        {
+            static constexpr int UnsetBoxId = -1;
+
+            path.clear();
+
+            if( state.costs.size() != m_level.m_boxes.size() )
+            {
+                state.costs.assign(m_level.m_boxes.size(), UnsetBoxId);
+                state.parents.assign(m_level.m_boxes.size(), UnsetBoxId);
+                state.visited.clear();
+            }
+
+            // only reset what the previous search touched
+            for( const auto box : state.visited )
+            {
+                state.costs[box] = UnsetBoxId;
+                state.parents[box] = UnsetBoxId;
+            }
+            state.visited.clear();
+
+            state.levelNodes.clear();
+            state.levelNodes.emplace_back(key.from);
+
+            state.costs[key.from] = 0;
+            state.visited.emplace_back(key.from);
+
+            for( uint16_t level = 1; level <= MaxDepth; ++level )
+            {
+                state.nextLevel.clear();
+
+                for( const auto levelBoxIdx : state.levelNodes )
+                {
+                    // examine edge levelBox --> childBox
+                    for( const auto childBox : getNeighbours(key.zoneType, key.roomsAreSwapped, levelBoxIdx) )
+                    {
+                        BOOST_ASSERT(childBox != levelBoxIdx);
+                        if( !canTravelFromTo(key, levelBoxIdx, childBox) )
+                        {
+                            continue;
+                        }
+
+                        const bool unvisited = state.costs[childBox] == UnsetBoxId;
+                        if( unvisited )
+                            state.visited.emplace_back(childBox);
+
+                        if( unvisited || level < state.costs[childBox] )
+                        {
+                            state.costs[childBox] = level;
+                            state.parents[childBox] = levelBoxIdx;
+                        }
+
+                        if( childBox == key.to )
+                        {
+                            auto current = key.to;
+                            path.emplace_back(current);
+                            while( state.parents[current] != UnsetBoxId )
+                            {
+                                current = gsl::narrow_cast<uint16_t>(state.parents[current]);
+                                path.emplace_back(current);
+                            }
+
+                            std::reverse(path.begin(), path.end());
+
+                            BOOST_ASSERT(path.front() == key.from);
+
+                            return;
+                        }
+
+                        if( unvisited )
+                        {
+                            state.nextLevel.emplace_back(childBox);
+                        }
+                    }
+                }
+
+                state.levelNodes.swap(state.nextLevel);
+            }
+
+            BOOST_ASSERT(path.empty());
+        }
+    }
+}
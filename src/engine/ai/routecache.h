@@ -0,0 +1,161 @@
+#pragma once
+
+#include "loader/datatypes.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <gsl/gsl>
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+
+namespace level
+{
+    class Level;
+}
+
+
+namespace engine
+{
+    namespace ai
+    {
+        //! @brief Selects one of the zone lists in @c loader::Zones.
+        enum class ZoneType : uint8_t
+        {
+            Ground1,
+            Ground2,
+            Fly
+        };
+
+
+        const loader::ZoneData& getZoneData(const level::Level& lvl, ZoneType zoneType, bool roomsAreSwapped);
+
+
+        /**
+         * @brief The box graph of a level, and the paths NPCs found through it.
+         *
+         * The overlap lists are flattened into one compressed adjacency list per zone type and room swap
+         * state, containing only the overlaps within the same zone, so a search doesn't need to scan
+         * for list terminators or check zones.
+         *
+         * Paths are cached per movement limits and box pair, so NPCs of the same kind chasing the same
+         * target share their searches.  As the search respects the blocking bits of the boxes, the
+         * paths must be invalidated when these change.
+         */
+        class RouteCache final : public boost::noncopyable
+        {
+        public:
+            //! Maximum number of boxes a path may step through
+            static constexpr uint16_t MaxDepth = 5;
+
+            struct PathKey
+            {
+                ZoneType zoneType;
+                bool roomsAreSwapped;
+                uint16_t blockMask;
+                int dropHeight;
+                int stepHeight;
+                uint16_t from;
+                uint16_t to;
+
+                bool operator==(const PathKey& rhs) const
+                {
+                    return zoneType == rhs.zoneType && roomsAreSwapped == rhs.roomsAreSwapped && blockMask == rhs.blockMask
+                           && dropHeight == rhs.dropHeight && stepHeight == rhs.stepHeight && from == rhs.from && to == rhs.to;
+                }
+            };
+
+
+            //! Scratch buffers of a search, so that searches don't allocate
+            struct SearchState
+            {
+                std::vector<int> costs;
+                std::vector<int> parents;
+                std::vector<uint16_t> visited;
+                std::vector<uint16_t> levelNodes;
+                std::vector<uint16_t> nextLevel;
+            };
+
+
+            explicit RouteCache(const level::Level& lvl);
+
+            ~RouteCache();
+
+            //! Boxes overlapping @a box within the same zone
+            gsl::span<const uint16_t> getNeighbours(ZoneType zoneType, bool roomsAreSwapped, uint16_t box) const;
+
+            /**
+             * @brief Box indices of the shortest path between two boxes.
+             *
+             * The path starts with PathKey::from and ends with PathKey::to; it is empty if the destination
+             * can't be reached within MaxDepth steps.
+             */
+            const std::vector<uint16_t>& getPath(const PathKey& key) const;
+
+            bool hasPath(const PathKey& key) const
+            {
+                return m_paths.find(key) != m_paths.end();
+            }
+
+            /**
+             * @brief Searches a path without touching the cache.
+             *
+             * This may be called concurrently, as long as each thread uses its own @a state and the level
+             * isn't modified; the result can be added to the cache using storePath().
+             */
+            void searchPath(const PathKey& key, SearchState& state, std::vector<uint16_t>& path) const;
+
+            void storePath(const PathKey& key, std::vector<uint16_t>&& path);
+
+            //! Must be called when the blocking bits of a box change.
+            void invalidatePaths();
+
+            size_t getHits() const noexcept
+            {
+                return m_hits;
+            }
+
+            size_t getMisses() const noexcept
+            {
+                return m_misses;
+            }
+
+        private:
+            struct Graph
+            {
+                //! Start of each box's neighbours in #neighbours, plus the end of the last box's neighbours
+                std::vector<uint32_t> offsets;
+                std::vector<uint16_t> neighbours;
+            };
+
+            struct PathKeyHash
+            {
+                size_t operator()(const PathKey& key) const;
+            };
+
+            //! Limits the memory spent on paths of NPCs that are long gone
+            static constexpr size_t MaxCachedPaths = 16384;
+
+            const level::Level& m_level;
+
+            //! Indexed by zone type and room swap state, see getGraphIndex()
+            std::array<Graph, 6> m_graphs;
+
+            mutable std::unordered_map<PathKey, std::vector<uint16_t>, PathKeyHash> m_paths;
+
+            //! Used by getPath()
+            mutable SearchState m_searchState;
+
+            mutable size_t m_hits = 0;
+            mutable size_t m_misses = 0;
+            size_t m_invalidations = 0;
+
+
+            static size_t getGraphIndex(ZoneType zoneType, bool roomsAreSwapped);
+
+            bool canTravelFromTo(const PathKey& key, uint16_t from, uint16_t to) const;
+        };
+    }
+}
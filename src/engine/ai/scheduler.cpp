@@ -0,0 +1,158 @@
+#include "scheduler.h"
+
+#include "engine/items/aiagent.h"
+#include "engine/laranode.h"
+#include "level/level.h"
+
+#include <boost/range/adaptors.hpp>
+
+
+namespace engine
+{
+    namespace ai
+    {
+        Scheduler::Scheduler(level::Level& lvl)
+            : m_level{lvl}
+        {
+            // m_itemNodes is ordered by item id, which keeps the staggering of the agents deterministic
+            for( const std::shared_ptr<items::ItemNode>& item : lvl.m_itemNodes | boost::adaptors::map_values )
+            {
+                if( auto agent = dynamic_cast<items::AIAgent*>(item.get()) )
+                    m_agents.emplace_back(agent);
+            }
+
+            BOOST_LOG_TRIVIAL(debug) << "AI scheduler: " << m_agents.size() << " agents";
+        }
+
+
+        Scheduler::~Scheduler()
+        {
+            BOOST_LOG_TRIVIAL(info) << "AI scheduler: " << m_thinkCount << " thinks, " << m_skipCount << " skipped";
+        }
+
+
+        void Scheduler::prepare()
+        {
+            ++m_tick;
+
+            m_thinking.clear();
+            for( size_t i = 0; i < m_agents.size(); ++i )
+            {
+                const auto agent = m_agents[i];
+                if( !agent->m_isActive || agent->getHealth() <= 0 )
+                {
+                    agent->setThinking(true);
+                    continue;
+                }
+
+                const bool thinking = (m_tick + i) % getThinkInterval(*agent) == 0;
+                agent->setThinking(thinking);
+                if( !thinking )
+                {
+                    ++m_skipCount;
+                    continue;
+                }
+
+                ++m_thinkCount;
+                m_thinking.emplace_back(agent);
+            }
+
+            // collect the path queries the agents will make; several agents may share one
+            m_missingPaths.clear();
+            const auto& lara = *m_level.m_lara;
+            if( lara.getCurrentBox().is_initialized() )
+            {
+                for( const auto agent : m_thinking )
+                {
+                    if( !agent->getCurrentBox().is_initialized() )
+                        continue;
+
+                    const auto key = agent->getBrain().route.getPathKey(*agent, lara);
+                    if( !m_level.m_routeCache->hasPath(key)
+                        && std::find(m_missingPaths.begin(), m_missingPaths.end(), key) == m_missingPaths.end() )
+                    {
+                        m_missingPaths.emplace_back(key);
+                    }
+                }
+            }
+
+            m_lookAheads.resize(m_thinking.size());
+            if( m_foundPaths.size() < m_missingPaths.size() )
+                m_foundPaths.resize(m_missingPaths.size());
+
+            const auto workCount = std::max(m_thinking.size(), m_missingPaths.size());
+            const auto jobCount = workCount < ParallelThreshold ? 1 : m_pool.getThreadCount();
+            if( m_searchStates.size() < jobCount )
+                m_searchStates.resize(jobCount);
+
+            if( jobCount == 1 )
+            {
+                prepareRange(0, 1);
+            }
+            else
+            {
+                m_jobs.clear();
+                for( size_t job = 0; job < jobCount; ++job )
+                {
+                    m_jobs.emplace_back(m_pool.enqueue([this, job, jobCount]()
+                                                       {
+                                                           prepareRange(job, jobCount);
+                                                       }));
+                }
+
+                for( auto& job : m_jobs )
+                    job.get();
+            }
+
+            // apply the results in a fixed order
+            for( size_t i = 0; i < m_thinking.size(); ++i )
+            {
+                if( m_lookAheads[i].is_initialized() )
+                    m_thinking[i]->setPreparedLookAhead(*m_lookAheads[i]);
+            }
+
+            for( size_t i = 0; i < m_missingPaths.size(); ++i )
+                m_level.m_routeCache->storePath(m_missingPaths[i], std::move(m_foundPaths[i]));
+        }
+
+
+        uint32_t Scheduler::getThinkInterval(const items::AIAgent& agent) const
+        {
+            static constexpr int NearDistance = 5 * loader::SectorSize;
+            static constexpr int FarDistance = 12 * loader::SectorSize;
+
+            const auto distance = agent.getPosition().distanceTo(m_level.m_lara->getPosition());
+            const bool hunting = agent.getBrain().mood != Mood::Bored;
+
+            if( distance < NearDistance )
+                return 1;
+            else if( distance < FarDistance )
+                return hunting ? 1 : 2;
+            else
+                return hunting ? 2 : 4;
+        }
+
+
+        void Scheduler::prepareRange(size_t job, size_t jobCount)
+        {
+            // only reads the level, and writes to the elements of this job
+            const auto agentsBegin = m_thinking.size() * job / jobCount;
+            const auto agentsEnd = m_thinking.size() * (job + 1) / jobCount;
+            for( auto i = agentsBegin; i < agentsEnd; ++i )
+            {
+                const auto agent = m_thinking[i];
+                if( agent->getLookAheadPivot().is_initialized() )
+                    m_lookAheads[i] = LookAhead{*agent, *agent->getLookAheadPivot()};
+                else
+                    m_lookAheads[i].reset();
+            }
+
+            const auto pathsBegin = m_missingPaths.size() * job / jobCount;
+            const auto pathsEnd = m_missingPaths.size() * (job + 1) / jobCount;
+            for( auto i = pathsBegin; i < pathsEnd; ++i )
+            {
+                m_level.m_routeCache->searchPath(m_missingPaths[i], m_searchStates[job], m_foundPaths[i]);
+            }
+        }
+    }
+}
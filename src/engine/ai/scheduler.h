@@ -0,0 +1,92 @@
+#pragma once
+
+#include "ai.h"
+#include "routecache.h"
+
+#include "util/threadpool.h"
+
+#include <boost/optional.hpp>
+
+#include <vector>
+
+
+namespace level
+{
+    class Level;
+}
+
+
+namespace engine
+{
+    namespace items
+    {
+        class AIAgent;
+    }
+
+    namespace ai
+    {
+        /**
+         * @brief Prepares the AI agents of a level before they are updated.
+         *
+         * Decides which agents think (update their mood and target) in the current tick: agents close to
+         * Lara or hunting her think every tick, distant and bored ones only every few ticks, staggered so
+         * that they don't all think in the same tick.  The decision only depends on the tick count and the
+         * game state, so the logic stays deterministic.
+         *
+         * The read-only parts of thinking, the LookAhead and the path query, are then computed for all
+         * thinking agents at once, in parallel if there are enough of them.  Their results are applied
+         * in a fixed order: paths are stored in the RouteCache, and the agents pick up their LookAhead
+         * when they are updated, unless they moved in between.
+         */
+        class Scheduler final : public boost::noncopyable
+        {
+        public:
+            //! Below this number of thinking agents, preparing them in parallel isn't worth the overhead
+            static constexpr size_t ParallelThreshold = 16;
+
+            explicit Scheduler(level::Level& lvl);
+
+            ~Scheduler();
+
+            //! Must be called once per logic tick, before the items are updated.
+            void prepare();
+
+            size_t getAgentCount() const noexcept
+            {
+                return m_agents.size();
+            }
+
+            size_t getThinkingAgentCount() const noexcept
+            {
+                return m_thinking.size();
+            }
+
+        private:
+            level::Level& m_level;
+            std::vector<items::AIAgent*> m_agents;
+            uint32_t m_tick = 0;
+
+            //! @brief Per-tick state, kept to avoid allocations
+            //! @{
+            std::vector<items::AIAgent*> m_thinking;
+            std::vector<boost::optional<LookAhead>> m_lookAheads;
+            std::vector<RouteCache::PathKey> m_missingPaths;
+            std::vector<std::vector<uint16_t>> m_foundPaths;
+            //! One per parallel job
+            std::vector<RouteCache::SearchState> m_searchStates;
+            std::vector<std::future<void>> m_jobs;
+            //! @}
+
+            size_t m_thinkCount = 0;
+            size_t m_skipCount = 0;
+
+            util::ThreadPool m_pool;
+
+
+            uint32_t getThinkInterval(const items::AIAgent& agent) const;
+
+            //! Computes the LookAheads and paths of one of @a jobCount equally sized parts of the work.
+            void prepareRange(size_t job, size_t jobCount);
+        };
+    }
+}
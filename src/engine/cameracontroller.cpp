@@ -126,8 +126,19 @@ namespace engine
         for( const loader::Room& room : m_level->m_rooms )
             room.node->setEnabled(false);
 
+        // the union of the screen rectangles of all portal paths leading to a room
+        static const gameplay::BoundingBox emptyRect{1, 1, 0, -1, -1, 0};
+        m_roomScreenRects.assign(m_level->m_rooms.size(), emptyRect);
+        const auto addScreenRect = [this](uint16_t roomIndex, const gameplay::BoundingBox& rect)
+        {
+            auto& roomRect = m_roomScreenRects[roomIndex];
+            roomRect.min = glm::min(roomRect.min, rect.min);
+            roomRect.max = glm::max(roomRect.max, rect.max);
+        };
+
         auto startRoom = m_currentPosition.room;
         startRoom->node->setEnabled(true);
+        addScreenRect(gsl::narrow<uint16_t>(startRoom - &m_level->m_rooms[0]), render::PortalTracer{}.boundingBox);
 
         // Breadth-first queue
         std::queue<render::PortalTracer> toVisit;
@@ -140,6 +151,7 @@ namespace engine
                 continue;
 
             m_level->m_rooms[portal.adjoining_room].node->setEnabled(true);
+            addScreenRect(portal.adjoining_room, path.boundingBox);
 
             toVisit.emplace(std::move(path));
         }
@@ -165,9 +177,48 @@ namespace engine
                     continue;
 
                 m_level->m_rooms[srcPortal.adjoining_room].node->setEnabled(true);
+                addScreenRect(srcPortal.adjoining_room, newPath.boundingBox);
                 toVisit.emplace(std::move(newPath));
             }
         }
+
+        m_cullingStatistics = {};
+        for( size_t i = 0; i < m_level->m_rooms.size(); ++i )
+        {
+            const loader::Room& room = m_level->m_rooms[i];
+            if( room.node->isEnabled() )
+                cullRoomContents(room, m_roomScreenRects[i]);
+        }
+    }
+
+
+    void CameraController::cullRoomContents(const loader::Room& room, const gameplay::BoundingBox& screenRect)
+    {
+        // items that are not indexed, i.e. dynamic ones, are never culled
+        for( items::ItemNode* item : room.items )
+        {
+            // the frame boxes are relative to the item, with Y and Z flipped in the render system
+            const auto frameBox = item->getBoundingBox();
+            gameplay::BoundingBox box{glm::vec3(frameBox.minX, -frameBox.maxY, -frameBox.maxZ),
+                                      glm::vec3(frameBox.maxX, -frameBox.minY, -frameBox.minZ)};
+            box.transform(item->getWorldMatrix());
+            cull(*item, box, screenRect);
+        }
+
+        for( const auto& staticMesh : room.staticMeshNodes )
+            cull(*staticMesh.first, staticMesh.second, screenRect);
+    }
+
+
+    void CameraController::cull(gameplay::Node& node, const gameplay::BoundingBox& box, const gameplay::BoundingBox& screenRect)
+    {
+        const bool visible = render::isVisible(box, screenRect, *m_camera.get());
+        node.setCulled(!visible);
+
+        if( visible )
+            ++m_cullingStatistics.drawn;
+        else
+            ++m_cullingStatistics.culled;
     }
 
 
@@ -367,7 +418,8 @@ namespace engine
             if( m_underwaterAmbience == nullptr )
             {
                 m_underwaterAmbience = m_level->playSound(60, boost::none);
-                m_underwaterAmbience->setLooping(true);
+                if( m_underwaterAmbience != nullptr )
+                    m_underwaterAmbience->setLooping(true);
             }
         }
         else if( m_underwaterAmbience != nullptr )
@@ -2,7 +2,8 @@
 
 #include "core/angle.h"
 #include "loader/datatypes.h"
-#include "audio/sourcehandle.h"
+#include "audio/voice.h"
+#include "render/culling.h"
 
 
 namespace engine
@@ -74,7 +75,11 @@ namespace engine
         //! @brief Floor-projected pivot distance, squared.
         int m_flatPivotDistanceSq = 0;
 
-        std::shared_ptr<audio::SourceHandle> m_underwaterAmbience;
+        std::shared_ptr<audio::Voice> m_underwaterAmbience;
+
+        //! The screen rectangles the rooms are visible through, in normalized device coordinates; built by tracePortals()
+        std::vector<gameplay::BoundingBox> m_roomScreenRects;
+        render::CullingStatistics m_cullingStatistics;
 
     public:
         explicit CameraController(gsl::not_null<level::Level*> level, gsl::not_null<LaraNode*> laraController, const gsl::not_null<std::shared_ptr<gameplay::Camera>>& camera);
@@ -160,8 +165,16 @@ namespace engine
         }
 
 
+        const render::CullingStatistics& getCullingStatistics() const noexcept
+        {
+            return m_cullingStatistics;
+        }
+
+
     private:
         void tracePortals();
+        void cullRoomContents(const loader::Room& room, const gameplay::BoundingBox& screenRect);
+        void cull(gameplay::Node& node, const gameplay::BoundingBox& box, const gameplay::BoundingBox& screenRect);
         bool clampY(const core::TRCoordinates& lookAt, core::TRCoordinates& origin, gsl::not_null<const loader::Sector*> sector) const;
 
 
@@ -4,6 +4,8 @@
 #include "level/level.h"
 #include "laranode.h"
 
+#include <algorithm>
+
 namespace engine
 {
     namespace
@@ -212,18 +214,29 @@ namespace engine
         }
     }
 
-    std::set<const loader::Room*> CollisionInfo::collectNeighborRooms(const core::TRCoordinates& position, int radius, int height, const level::Level& level)
+    CollisionInfo::NeighborRooms CollisionInfo::collectNeighborRooms(const core::TRCoordinates& position, int radius, int height, const level::Level& level)
     {
-        std::set<const loader::Room*> result;
-        result.insert(level.m_lara->getCurrentRoom());
-        result.insert(level.findRoomForPosition(position + core::TRCoordinates(radius, 0, radius), level.m_lara->getCurrentRoom()));
-        result.insert(level.findRoomForPosition(position + core::TRCoordinates(-radius, 0, radius), level.m_lara->getCurrentRoom()));
-        result.insert(level.findRoomForPosition(position + core::TRCoordinates(radius, 0, -radius), level.m_lara->getCurrentRoom()));
-        result.insert(level.findRoomForPosition(position + core::TRCoordinates(-radius, 0, -radius), level.m_lara->getCurrentRoom()));
-        result.insert(level.findRoomForPosition(position + core::TRCoordinates(radius, -height, radius), level.m_lara->getCurrentRoom()));
-        result.insert(level.findRoomForPosition(position + core::TRCoordinates(-radius, -height, radius), level.m_lara->getCurrentRoom()));
-        result.insert(level.findRoomForPosition(position + core::TRCoordinates(radius, -height, -radius), level.m_lara->getCurrentRoom()));
-        result.insert(level.findRoomForPosition(position + core::TRCoordinates(-radius, -height, -radius), level.m_lara->getCurrentRoom()));
+        const auto laraRoom = level.m_lara->getCurrentRoom();
+
+        NeighborRooms result;
+        result.emplace_back(laraRoom);
+        for( const auto& corner : {
+                 core::TRCoordinates(radius, 0, radius),
+                 core::TRCoordinates(-radius, 0, radius),
+                 core::TRCoordinates(radius, 0, -radius),
+                 core::TRCoordinates(-radius, 0, -radius),
+                 core::TRCoordinates(radius, -height, radius),
+                 core::TRCoordinates(-radius, -height, radius),
+                 core::TRCoordinates(radius, -height, -radius),
+                 core::TRCoordinates(-radius, -height, -radius)
+             } )
+        {
+            result.emplace_back(level.findRoomForPosition(position + corner, laraRoom));
+        }
+
+        // the rooms are stored in one vector, so this visits them in room order
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
         return result;
     }
 
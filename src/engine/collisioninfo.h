@@ -3,7 +3,7 @@
 #include "heightinfo.h"
 #include "core/angle.h"
 
-#include <set>
+#include <boost/container/static_vector.hpp>
 
 namespace engine
 {
@@ -56,7 +56,10 @@ namespace engine
 
         void initHeightInfo(const core::TRCoordinates& laraPos, const level::Level& level, int height);
 
-        static std::set<const loader::Room*> collectNeighborRooms(const core::TRCoordinates& position, int radius, int height, const level::Level& level);
+        //! Lara's room and the rooms at the corners of the given box, without duplicates and in room order
+        using NeighborRooms = boost::container::static_vector<const loader::Room*, 9>;
+
+        static NeighborRooms collectNeighborRooms(const core::TRCoordinates& position, int radius, int height, const level::Level& level);
         bool checkStaticMeshCollisions(const core::TRCoordinates& position, int height, const level::Level& level);
     };
 }
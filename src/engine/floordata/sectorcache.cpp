@@ -0,0 +1,188 @@
+#include "sectorcache.h"
+
+#include "level/level.h"
+
+#include <algorithm>
+#include <functional>
+
+
+namespace engine
+{
+    namespace floordata
+    {
+        SectorCache::SectorCache(level::Level& lvl)
+            : m_level{lvl}
+        {
+            rebuild();
+
+            BOOST_LOG_TRIVIAL(debug) << "Sector cache: " << m_sectors.size() << " sectors, "
+                                     << m_activatedItems.size() << " item activations";
+        }
+
+
+        void SectorCache::rebuild()
+        {
+            size_t sectorCount = 0;
+            for( const loader::Room& room : m_level.m_rooms )
+                sectorCount += room.sectors.size();
+
+            m_sectors.clear();
+            m_sectors.resize(sectorCount);
+            m_roomSectors.clear();
+            m_activatedItems.clear();
+
+            // the item lists are only referenced after all sectors are decoded, as the storage may still grow
+            std::vector<std::pair<size_t, size_t>> activatedItemRanges;
+            activatedItemRanges.reserve(sectorCount);
+
+            size_t idx = 0;
+            for( const loader::Room& room : m_level.m_rooms )
+            {
+                if( !room.sectors.empty() )
+                    m_roomSectors.emplace_back(RoomSectors{room.sectors.data(), room.sectors.size(), idx});
+
+                // the decoded sectors are stored in the same order as the room's sectors
+                for( int dx = 0; dx < room.sectorCountX; ++dx )
+                {
+                    for( int dz = 0; dz < room.sectorCountZ; ++dz )
+                    {
+                        const loader::Sector& sector = room.sectors[room.sectorCountZ * dx + dz];
+                        DecodedSector& decoded = m_sectors[idx++];
+
+                        const auto center = room.position + core::TRCoordinates(dx * loader::SectorSize + loader::SectorSize / 2,
+                                                                                0,
+                                                                                dz * loader::SectorSize + loader::SectorSize / 2);
+                        decoded.floorSector = followRoomsBelow(&sector, center);
+                        decoded.ceilingSector = followRoomsAbove(&sector, center);
+
+                        const auto activatedItemsBegin = m_activatedItems.size();
+                        decode(sector, decoded);
+                        activatedItemRanges.emplace_back(activatedItemsBegin, m_activatedItems.size());
+                    }
+                }
+            }
+
+            BOOST_ASSERT(idx == m_sectors.size());
+
+            std::sort(m_roomSectors.begin(), m_roomSectors.end(), [](const RoomSectors& a, const RoomSectors& b)
+            {
+                return std::less<const loader::Sector*>()(a.first, b.first);
+            });
+
+            for( size_t i = 0; i < m_sectors.size(); ++i )
+            {
+                const auto& range = activatedItemRanges[i];
+                m_sectors[i].activatedItems = gsl::span<const uint16_t>(m_activatedItems.data() + range.first,
+                                                                        m_activatedItems.data() + range.second);
+            }
+        }
+
+
+        const DecodedSector& SectorCache::get(gsl::not_null<const loader::Sector*> sector) const
+        {
+            auto it = std::upper_bound(m_roomSectors.begin(), m_roomSectors.end(), sector.get(), [](const loader::Sector* s, const RoomSectors& room)
+            {
+                return std::less<const loader::Sector*>()(s, room.first);
+            });
+            Expects(it != m_roomSectors.begin());
+            --it;
+
+            const auto idx = static_cast<size_t>(sector.get() - it->first);
+            Expects(idx < it->count);
+            return m_sectors[it->offset + idx];
+        }
+
+
+        void SectorCache::decode(const loader::Sector& sector, DecodedSector& decoded)
+        {
+            if( sector.floorDataIndex == 0 )
+                return;
+
+            decoded.portalTarget = getPortalTarget(m_level.m_floorData, sector.floorDataIndex);
+
+            const FloorData::value_type* floorData = &m_level.m_floorData[sector.floorDataIndex];
+            while( true )
+            {
+                const FloorDataChunk chunkHeader{*floorData++};
+                switch( chunkHeader.type )
+                {
+                    case FloorDataChunkType::FloorSlant:
+                        decoded.hasFloorSlant = true;
+                        decoded.floorSlantX = gsl::narrow_cast<int8_t>(*floorData & 0xff);
+                        decoded.floorSlantZ = gsl::narrow_cast<int8_t>((*floorData >> 8) & 0xff);
+                        ++floorData;
+                        break;
+                    case FloorDataChunkType::CeilingSlant:
+                        decoded.hasCeilingSlant = true;
+                        decoded.ceilingSlantX = gsl::narrow_cast<int8_t>(*floorData & 0xff);
+                        decoded.ceilingSlantZ = gsl::narrow_cast<int8_t>((*floorData >> 8) & 0xff);
+                        ++floorData;
+                        break;
+                    case FloorDataChunkType::PortalSector:
+                        ++floorData;
+                        break;
+                    case FloorDataChunkType::Death:
+                        decoded.lastCommandSequenceOrDeath = floorData - 1;
+                        break;
+                    case FloorDataChunkType::CommandSequence:
+                        if( !decoded.lastCommandSequenceOrDeath )
+                            decoded.lastCommandSequenceOrDeath = floorData - 1;
+                        ++floorData;
+                        while( true )
+                        {
+                            const Command command{*floorData++};
+
+                            if( command.opcode == CommandOpcode::Activate )
+                            {
+                                m_activatedItems.emplace_back(command.parameter);
+                            }
+                            else if( command.opcode == CommandOpcode::SwitchCamera )
+                            {
+                                command.isLast = CameraParameters{*floorData++}.isLast;
+                            }
+
+                            if( command.isLast )
+                                break;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                if( chunkHeader.isLast )
+                    break;
+            }
+        }
+
+
+        const loader::Sector* SectorCache::followRoomsBelow(const loader::Sector* sector, const core::TRCoordinates& position) const
+        {
+            while( sector->roomBelow != 0xff )
+            {
+                BOOST_ASSERT(sector->roomBelow < m_level.m_rooms.size());
+                const auto below = m_level.m_rooms[sector->roomBelow].getSectorByAbsolutePosition(position);
+                if( below == nullptr )
+                    break;
+
+                sector = below;
+            }
+
+            return sector;
+        }
+
+
+        const loader::Sector* SectorCache::followRoomsAbove(const loader::Sector* sector, const core::TRCoordinates& position) const
+        {
+            while( sector->roomAbove != 0xff )
+            {
+                BOOST_ASSERT(sector->roomAbove < m_level.m_rooms.size());
+                const auto above = m_level.m_rooms[sector->roomAbove].getSectorByAbsolutePosition(position);
+                if( above == nullptr )
+                    break;
+
+                sector = above;
+            }
+
+            return sector;
+        }
+    }
+}
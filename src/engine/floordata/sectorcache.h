@@ -0,0 +1,95 @@
+#pragma once
+
+#include "floordata.h"
+
+#include "core/coordinates.h"
+
+#include <boost/noncopyable.hpp>
+
+
+namespace level
+{
+    class Level;
+}
+
+
+namespace loader
+{
+    struct Sector;
+}
+
+
+namespace engine
+{
+    namespace floordata
+    {
+        //! @brief The floor data of a sector, and the sectors its room links lead to.
+        struct DecodedSector
+        {
+            //! The sector holding the floor, at the end of the roomBelow links
+            const loader::Sector* floorSector = nullptr;
+            //! The sector holding the ceiling, at the end of the roomAbove links
+            const loader::Sector* ceilingSector = nullptr;
+
+            boost::optional<uint8_t> portalTarget;
+
+            bool hasFloorSlant = false;
+            int8_t floorSlantX = 0;
+            int8_t floorSlantZ = 0;
+
+            bool hasCeilingSlant = false;
+            int8_t ceilingSlantX = 0;
+            int8_t ceilingSlantZ = 0;
+
+            //! The chunk header of the last death chunk, or else of the first command sequence
+            const FloorData::value_type* lastCommandSequenceOrDeath = nullptr;
+
+            //! Items activated by the command sequences; they may patch the floor or ceiling height
+            gsl::span<const uint16_t> activatedItems;
+        };
+
+
+        /**
+         * @brief Decodes the floor data of all sectors of a level once.
+         *
+         * Height queries would otherwise walk the room links and parse the floor data on every call.
+         * The floor and ceiling heights are not copied, but read from the resolved sectors, so patching
+         * them for blocks doesn't invalidate anything.  The room links however lead to other sectors
+         * when rooms are swapped with their alternates.
+         */
+        class SectorCache final : public boost::noncopyable
+        {
+        public:
+            explicit SectorCache(level::Level& lvl);
+
+            //! Must be called after swapping the rooms with their alternates.
+            void rebuild();
+
+            //! The decoded data of a sector of one of the level's rooms
+            const DecodedSector& get(gsl::not_null<const loader::Sector*> sector) const;
+
+        private:
+            //! The sectors of a room, and the index of the decoded data of the first one
+            struct RoomSectors
+            {
+                const loader::Sector* first;
+                size_t count;
+                size_t offset;
+            };
+
+
+            level::Level& m_level;
+            std::vector<DecodedSector> m_sectors;
+            //! Sorted by the address of the first sector, so the room of a sector can be searched
+            std::vector<RoomSectors> m_roomSectors;
+            std::vector<uint16_t> m_activatedItems;
+
+
+            void decode(const loader::Sector& sector, DecodedSector& decoded);
+
+            const loader::Sector* followRoomsBelow(const loader::Sector* sector, const core::TRCoordinates& position) const;
+
+            const loader::Sector* followRoomsAbove(const loader::Sector* sector, const core::TRCoordinates& position) const;
+        };
+    }
+}
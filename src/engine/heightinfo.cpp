@@ -15,101 +15,58 @@ namespace engine
 
         hi.slantClass = SlantClass::None;
 
-        while( roomSector->roomBelow != 0xff )
-        {
-            BOOST_ASSERT(roomSector->roomBelow < camera->getLevel()->m_rooms.size());
-            auto room = &camera->getLevel()->m_rooms[roomSector->roomBelow];
-            roomSector = room->getSectorByAbsolutePosition(pos);
-        }
+        const auto& sectorCache = *camera->getLevel()->m_sectorCache;
+        roomSector = sectorCache.get(roomSector).floorSector;
+        const auto& decoded = sectorCache.get(roomSector);
 
         hi.distance = roomSector->floorHeight * loader::QuarterSectorSize;
-        hi.lastCommandSequenceOrDeath = nullptr;
-
-        if( roomSector->floorDataIndex == 0 )
-        {
-            return hi;
-        }
+        hi.lastCommandSequenceOrDeath = decoded.lastCommandSequenceOrDeath;
 
-        const uint16_t* floorData = &camera->getLevel()->m_floorData[roomSector->floorDataIndex];
-        while( true )
+        if( decoded.hasFloorSlant )
         {
-            const floordata::FloorDataChunk chunkHeader{*floorData++};
-            switch( chunkHeader.type )
+            const int8_t xSlant = decoded.floorSlantX;
+            const auto absX = std::abs(xSlant);
+            const int8_t zSlant = decoded.floorSlantZ;
+            const auto absZ = std::abs(zSlant);
+            if( !skipSteepSlants || (absX <= 2 && absZ <= 2) )
             {
-                case floordata::FloorDataChunkType::FloorSlant:
+                if( absX <= 2 && absZ <= 2 )
+                    hi.slantClass = SlantClass::Max512;
+                else
+                    hi.slantClass = SlantClass::Steep;
+
+                const auto localX = pos.X % loader::SectorSize;
+                const auto localZ = pos.Z % loader::SectorSize;
+
+                if( zSlant > 0 ) // lower edge at -Z
+                {
+                    auto dist = loader::SectorSize - localZ;
+                    hi.distance += dist * zSlant * loader::QuarterSectorSize / loader::SectorSize;
+                }
+                else if( zSlant < 0 ) // lower edge at +Z
                 {
-                    const int8_t xSlant = gsl::narrow_cast<int8_t>(*floorData & 0xff);
-                    const auto absX = std::abs(xSlant);
-                    const int8_t zSlant = gsl::narrow_cast<int8_t>((*floorData >> 8) & 0xff);
-                    const auto absZ = std::abs(zSlant);
-                    if( !skipSteepSlants || (absX <= 2 && absZ <= 2) )
-                    {
-                        if( absX <= 2 && absZ <= 2 )
-                            hi.slantClass = SlantClass::Max512;
-                        else
-                            hi.slantClass = SlantClass::Steep;
-
-                        const auto localX = pos.X % loader::SectorSize;
-                        const auto localZ = pos.Z % loader::SectorSize;
-
-                        if( zSlant > 0 ) // lower edge at -Z
-                        {
-                            auto dist = loader::SectorSize - localZ;
-                            hi.distance += dist * zSlant * loader::QuarterSectorSize / loader::SectorSize;
-                        }
-                        else if( zSlant < 0 ) // lower edge at +Z
-                        {
-                            auto dist = localZ;
-                            hi.distance -= dist * zSlant * loader::QuarterSectorSize / loader::SectorSize;
-                        }
-
-                        if( xSlant > 0 ) // lower edge at -X
-                        {
-                            auto dist = loader::SectorSize - localX;
-                            hi.distance += dist * xSlant * loader::QuarterSectorSize / loader::SectorSize;
-                        }
-                        else if( xSlant < 0 ) // lower edge at +X
-                        {
-                            auto dist = localX;
-                            hi.distance -= dist * xSlant * loader::QuarterSectorSize / loader::SectorSize;
-                        }
-                    }
+                    auto dist = localZ;
+                    hi.distance -= dist * zSlant * loader::QuarterSectorSize / loader::SectorSize;
+                }
+
+                if( xSlant > 0 ) // lower edge at -X
+                {
+                    auto dist = loader::SectorSize - localX;
+                    hi.distance += dist * xSlant * loader::QuarterSectorSize / loader::SectorSize;
+                }
+                else if( xSlant < 0 ) // lower edge at +X
+                {
+                    auto dist = localX;
+                    hi.distance -= dist * xSlant * loader::QuarterSectorSize / loader::SectorSize;
                 }
-                    // Fall-through
-                case floordata::FloorDataChunkType::CeilingSlant:
-                case floordata::FloorDataChunkType::PortalSector:
-                    ++floorData;
-                    break;
-                case floordata::FloorDataChunkType::Death:
-                    hi.lastCommandSequenceOrDeath = floorData - 1;
-                    break;
-                case floordata::FloorDataChunkType::CommandSequence:
-                    if( !hi.lastCommandSequenceOrDeath )
-                        hi.lastCommandSequenceOrDeath = floorData - 1;
-                    ++floorData;
-                    while( true )
-                    {
-                        const floordata::Command command{*floorData++};
-
-                        if( command.opcode == floordata::CommandOpcode::Activate )
-                        {
-                            auto it = camera->getLevel()->m_itemNodes.find(command.parameter);
-                            Expects(it != camera->getLevel()->m_itemNodes.end());
-                            it->second->patchFloor(pos, hi.distance);
-                        }
-                        else if( command.opcode == floordata::CommandOpcode::SwitchCamera )
-                        {
-                            command.isLast = floordata::CameraParameters{ *floorData++ }.isLast;
-                        }
-
-                        if( command.isLast )
-                            break;
-                    }
-                default:
-                    break;
             }
-            if( chunkHeader.isLast )
-                break;
+        }
+
+        for( const auto itemId : decoded.activatedItems )
+        {
+            auto it = camera->getLevel()->m_itemNodes.find(itemId);
+            Expects(it != camera->getLevel()->m_itemNodes.end());
+            it->second->patchFloor(pos, hi.distance);
         }
 
         return hi;
@@ -120,115 +77,53 @@ namespace engine
     {
         HeightInfo hi;
 
-        while( roomSector->roomAbove != 0xff )
-        {
-            BOOST_ASSERT(roomSector->roomAbove < camera->getLevel()->m_rooms.size());
-            auto room = &camera->getLevel()->m_rooms[roomSector->roomAbove];
-            roomSector = room->getSectorByAbsolutePosition(pos);
-        }
+        const auto& sectorCache = *camera->getLevel()->m_sectorCache;
+        roomSector = sectorCache.get(roomSector).ceilingSector;
+        const auto& decoded = sectorCache.get(roomSector);
 
         hi.distance = roomSector->ceilingHeight * loader::QuarterSectorSize;
 
-        if( roomSector->floorDataIndex != 0 )
+        if( decoded.hasCeilingSlant )
         {
-            const uint16_t* floorData = &camera->getLevel()->m_floorData[roomSector->floorDataIndex];
-            floordata::FloorDataChunk chunkHeader{*floorData};
-            ++floorData;
-
-            if( chunkHeader.type == floordata::FloorDataChunkType::FloorSlant )
+            const int8_t xSlant = decoded.ceilingSlantX;
+            const auto absX = std::abs(xSlant);
+            const int8_t zSlant = decoded.ceilingSlantZ;
+            const auto absZ = std::abs(zSlant);
+            if( !skipSteepSlants || (absX <= 2 && absZ <= 2) )
             {
-                ++floorData;
+                const auto localX = pos.X % loader::SectorSize;
+                const auto localZ = pos.Z % loader::SectorSize;
 
-                chunkHeader = floordata::FloorDataChunk{*floorData};
-                ++floorData;
-            }
+                if( zSlant > 0 ) // lower edge at -Z
+                {
+                    auto dist = loader::SectorSize - localZ;
+                    hi.distance -= dist * zSlant * loader::QuarterSectorSize / loader::SectorSize;
+                }
+                else if( zSlant < 0 ) // lower edge at +Z
+                {
+                    auto dist = localZ;
+                    hi.distance += dist * zSlant * loader::QuarterSectorSize / loader::SectorSize;
+                }
 
-            if( chunkHeader.type == floordata::FloorDataChunkType::CeilingSlant )
-            {
-                const int8_t xSlant = gsl::narrow_cast<int8_t>(*floorData & 0xff);
-                const auto absX = std::abs(xSlant);
-                const int8_t zSlant = gsl::narrow_cast<int8_t>((*floorData >> 8) & 0xff);
-                const auto absZ = std::abs(zSlant);
-                if( !skipSteepSlants || (absX <= 2 && absZ <= 2) )
+                if( xSlant > 0 ) // lower edge at -X
                 {
-                    const auto localX = pos.X % loader::SectorSize;
-                    const auto localZ = pos.Z % loader::SectorSize;
-
-                    if( zSlant > 0 ) // lower edge at -Z
-                    {
-                        auto dist = loader::SectorSize - localZ;
-                        hi.distance -= dist * zSlant * loader::QuarterSectorSize / loader::SectorSize;
-                    }
-                    else if( zSlant < 0 ) // lower edge at +Z
-                    {
-                        auto dist = localZ;
-                        hi.distance += dist * zSlant * loader::QuarterSectorSize / loader::SectorSize;
-                    }
-
-                    if( xSlant > 0 ) // lower edge at -X
-                    {
-                        auto dist = localX;
-                        hi.distance -= dist * xSlant * loader::QuarterSectorSize / loader::SectorSize;
-                    }
-                    else if( xSlant < 0 ) // lower edge at +X
-                    {
-                        auto dist = loader::SectorSize - localX;
-                        hi.distance += dist * xSlant * loader::QuarterSectorSize / loader::SectorSize;
-                    }
+                    auto dist = localX;
+                    hi.distance -= dist * xSlant * loader::QuarterSectorSize / loader::SectorSize;
+                }
+                else if( xSlant < 0 ) // lower edge at +X
+                {
+                    auto dist = loader::SectorSize - localX;
+                    hi.distance += dist * xSlant * loader::QuarterSectorSize / loader::SectorSize;
                 }
             }
         }
 
-        while( true )
-        {
-            if( roomSector->roomBelow == 255 )
-                break;
-
-            roomSector = camera->getLevel()->m_rooms[roomSector->roomBelow].getSectorByAbsolutePosition(pos);
-        }
-
-        if( roomSector->floorDataIndex == 0 )
-            return hi;
-
-        const uint16_t* floorData = &camera->getLevel()->m_floorData[roomSector->floorDataIndex];
-        while( true )
+        // the items patching the ceiling are triggered from the floor below
+        for( const auto itemId : sectorCache.get(decoded.floorSector).activatedItems )
         {
-            floordata::FloorDataChunk chunkHeader{*floorData};
-            ++floorData;
-            switch( chunkHeader.type )
-            {
-                case floordata::FloorDataChunkType::CeilingSlant:
-                case floordata::FloorDataChunkType::FloorSlant:
-                case floordata::FloorDataChunkType::PortalSector:
-                    ++floorData;
-                    break;
-                case floordata::FloorDataChunkType::Death:
-                    break;
-                case floordata::FloorDataChunkType::CommandSequence:
-                    ++floorData;
-                    while( true )
-                    {
-                        const floordata::Command command{*floorData++};
-
-                        if( command.opcode == floordata::CommandOpcode::Activate )
-                        {
-                            auto it = camera->getLevel()->m_itemNodes.find(command.parameter);
-                            Expects(it != camera->getLevel()->m_itemNodes.end());
-                            it->second->patchCeiling(pos, hi.distance);
-                        }
-                        else if( command.opcode == floordata::CommandOpcode::SwitchCamera )
-                        {
-                            command.isLast = floordata::CameraParameters{ *floorData++ }.isLast;
-                        }
-
-                        if( command.isLast )
-                            break;
-                    }
-                default:
-                    break;
-            }
-            if( chunkHeader.isLast )
-                break;
+            auto it = camera->getLevel()->m_itemNodes.find(itemId);
+            Expects(it != camera->getLevel()->m_itemNodes.end());
+            it->second->patchCeiling(pos, hi.distance);
         }
 
         return hi;
@@ -43,6 +43,29 @@ namespace engine
         }
 
 
+        ai::LookAhead AIAgent::getLookAhead(int pivotDistance)
+        {
+            const bool prepared = m_preparedLookAhead.is_initialized()
+                                  && pivotDistance == m_lookAheadPivot
+                                  && m_preparedLookAheadPosition.X == getPosition().X
+                                  && m_preparedLookAheadPosition.Y == getPosition().Y
+                                  && m_preparedLookAheadPosition.Z == getPosition().Z
+                                  && m_preparedLookAheadRotation == getRotation().Y;
+
+            m_lookAheadPivot = pivotDistance;
+
+            if( !prepared )
+            {
+                m_preparedLookAhead.reset();
+                return ai::LookAhead{*this, pivotDistance};
+            }
+
+            auto lookAhead = *m_preparedLookAhead;
+            m_preparedLookAhead.reset();
+            return lookAhead;
+        }
+
+
         bool AIAgent::isPositionOutOfReach(const core::TRCoordinates& testPosition, int currentBoxFloor, const ai::RoutePlanner& routePlanner) const
         {
             const auto sectorBoxIdx = getLevel().findRealFloorSector(testPosition, getCurrentRoom())->boxIndex;
@@ -41,6 +41,45 @@ namespace engine
                 return m_zone;
             }
 
+
+            const ai::Brain& getBrain() const
+            {
+                return m_brain;
+            }
+
+
+            int getHealth() const
+            {
+                return m_health;
+            }
+
+
+            //! @name Set up by ai::Scheduler before the agent is updated
+            //! @{
+
+            //! Whether the agent may update its mood and target in this tick
+            void setThinking(bool thinking) noexcept
+            {
+                m_thinking = thinking;
+            }
+
+
+            //! Pivot distance used by the last getLookAhead() call
+            const boost::optional<int>& getLookAheadPivot() const noexcept
+            {
+                return m_lookAheadPivot;
+            }
+
+
+            void setPreparedLookAhead(const ai::LookAhead& lookAhead)
+            {
+                m_preparedLookAhead = lookAhead;
+                m_preparedLookAheadPosition = getPosition();
+                m_preparedLookAheadRotation = getRotation().Y;
+            }
+
+            //! @}
+
         protected:
             ai::Brain& getBrain()
             {
@@ -48,6 +87,16 @@ namespace engine
             }
 
 
+            bool isThinking() const noexcept
+            {
+                return m_thinking;
+            }
+
+
+            //! Uses the LookAhead prepared by the ai::Scheduler if the agent didn't move since.
+            ai::LookAhead getLookAhead(int pivotDistance);
+
+
             void rotateCreatureTilt(core::Angle angle)
             {
                 const auto dz = core::Angle(4 * angle.toAU()) - getRotation().Z;
@@ -68,12 +117,6 @@ namespace engine
             core::Angle rotateTowardsMoveTarget(const ai::Brain& creatureData, core::Angle maxRotationSpeed);
 
 
-            int getHealth() const
-            {
-                return m_health;
-            }
-
-
         private:
 
             bool anyMovingEnabledItemInReach() const;
@@ -85,6 +128,12 @@ namespace engine
             int m_health{ 1000 };
             const int m_collisionRadius;
             const uint16_t m_zone;
+
+            bool m_thinking = true;
+            boost::optional<int> m_lookAheadPivot;
+            boost::optional<ai::LookAhead> m_preparedLookAhead;
+            core::TRCoordinates m_preparedLookAheadPosition;
+            core::Angle m_preparedLookAheadRotation;
         };
     }
 }
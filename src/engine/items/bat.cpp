@@ -24,9 +24,10 @@ namespace engine
             core::Angle rotationToMoveTarget = 0_deg;
             if( getHealth() > 0 )
             {
-                ai::LookAhead lookAhead(*this, 0);
+                auto lookAhead = getLookAhead(0);
 
-                getBrain().route.updateMood(getBrain(), lookAhead, *this, false, 1024);
+                if( isThinking() )
+                    getBrain().route.updateMood(getBrain(), lookAhead, *this, false, 1024);
                 rotationToMoveTarget = rotateTowardsMoveTarget(getBrain(), 20_deg);
                 switch( getCurrentState() )
                 {
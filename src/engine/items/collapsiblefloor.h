@@ -26,6 +26,12 @@ namespace engine
             void update() override;
 
 
+            bool needsUpdate() const override
+            {
+                return m_isActive;
+            }
+
+
             void onInteract(LaraNode& /*lara*/) override
             {
             }
@@ -3,11 +3,22 @@
 #include "engine/laranode.h"
 #include "level/level.h"
 
+#include <algorithm>
+
 
 namespace engine
 {
     namespace items
     {
+        namespace
+        {
+            bool isLowerItemId(const ItemNode* a, const ItemNode* b)
+            {
+                return *a->getItemId() < *b->getItemId();
+            }
+        }
+
+
         void ItemNode::applyTransform()
         {
             glm::vec3 tr;
@@ -45,9 +56,12 @@ namespace engine
             , m_hasProcessAnimCommandsOverride(hasProcessAnimCommandsOverride)
             , m_characteristics(characteristics)
             , m_darkness{darkness}
+            , m_lightIndex{level->m_itemLighting->allocate()}
         {
             BOOST_ASSERT(room->isInnerPositionXZ(position));
 
+            bindLighting(*this);
+
             if( m_activationState.isOneshot() )
             {
                 setEnabled(false);
@@ -85,7 +99,57 @@ namespace engine
 
             newRoom->node->addChild(shared_from_this());
 
-            m_position.room = newRoom;
+            if( m_itemId.is_initialized() )
+            {
+                removeFromRoomIndex();
+                m_position.room = newRoom;
+                addToRoomIndex();
+            }
+            else
+            {
+                m_position.room = newRoom;
+            }
+        }
+
+
+        void ItemNode::setItemId(uint16_t itemId)
+        {
+            Expects(!m_itemId.is_initialized());
+
+            m_itemId = itemId;
+            addToRoomIndex();
+            updateActiveItemsMembership();
+        }
+
+
+        void ItemNode::addToRoomIndex()
+        {
+            auto& items = m_position.room->items;
+            items.insert(std::lower_bound(items.begin(), items.end(), this, &isLowerItemId), this);
+        }
+
+
+        void ItemNode::removeFromRoomIndex()
+        {
+            auto& items = m_position.room->items;
+            const auto it = std::lower_bound(items.begin(), items.end(), this, &isLowerItemId);
+            BOOST_ASSERT(it != items.end() && *it == this);
+            items.erase(it);
+        }
+
+
+        void ItemNode::updateActiveItemsMembership()
+        {
+            if( !m_itemId.is_initialized() )
+                return;
+
+            auto& items = getLevel().m_activeItems;
+            const auto it = std::lower_bound(items.begin(), items.end(), this, &isLowerItemId);
+            const bool isListed = it != items.end() && *it == this;
+            if( needsUpdate() && !isListed )
+                items.insert(it, this);
+            else if( !needsUpdate() && isListed )
+                items.erase(it);
         }
 
 
@@ -206,6 +270,7 @@ namespace engine
             }
 
             m_isActive = true;
+            updateActiveItemsMembership();
         }
 
 
@@ -221,10 +286,11 @@ namespace engine
             }
 
             m_isActive = false;
+            updateActiveItemsMembership();
         }
 
 
-        std::shared_ptr<audio::SourceHandle> ItemNode::playSoundEffect(int id)
+        std::shared_ptr<audio::Voice> ItemNode::playSoundEffect(int id)
         {
             auto handle = getLevel().playSound(id, getTranslationWorld());
             if( handle != nullptr )
@@ -254,19 +320,17 @@ namespace engine
 
         void ItemNode::updateSounds()
         {
-            decltype(m_sounds) cleaned;
-            std::copy_if(m_sounds.begin(), m_sounds.end(), inserter(cleaned, cleaned.end()),
-                         [](const std::weak_ptr<audio::SourceHandle>& h)
-                     {
-                         return h.expired();
-                     });
-
-            m_sounds = std::move(cleaned);
-
-            for( const std::weak_ptr<audio::SourceHandle>& handle : m_sounds )
+            for( auto it = m_sounds.begin(); it != m_sounds.end(); )
             {
-                std::shared_ptr<audio::SourceHandle> lockedHandle = handle.lock();
-                lockedHandle->setPosition(getTranslationWorld());
+                if( auto voice = it->lock() )
+                {
+                    voice->setPosition(getTranslationWorld());
+                    ++it;
+                }
+                else
+                {
+                    it = m_sounds.erase(it);
+                }
             }
         }
 
@@ -322,6 +386,25 @@ namespace engine
 
             updatePose();
             updateLighting();
+            m_level->m_itemLighting->set(m_lightIndex, m_lighting);
+        }
+
+
+        ItemNode::~ItemNode()
+        {
+            // the level destroys its items before the lighting
+            if( m_level->m_itemLighting != nullptr )
+                m_level->m_itemLighting->release(m_lightIndex);
+        }
+
+
+        void ItemNode::bindLighting(gameplay::Node& node) const
+        {
+            const auto lightIndex = m_lightIndex;
+            node.addMaterialParameterSetter("u_itemLight", [lightIndex](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
+            {
+                uniform.set(lightIndex);
+            });
         }
 
 
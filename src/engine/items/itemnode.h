@@ -1,8 +1,9 @@
 #pragma once
 
-#include "audio/sourcehandle.h"
+#include "audio/voice.h"
 #include "engine/floordata/floordata.h"
 #include "engine/skeletalmodelnode.h"
+#include "render/itemlighting.h"
 
 #include <set>
 
@@ -74,10 +75,19 @@ namespace engine
 
             int m_floorHeight = 0;
 
-            std::set<std::weak_ptr<audio::SourceHandle>, audio::WeakSourceHandleLessComparator> m_sounds;
+            //! Index in the level's item list; not set for items created at runtime
+            boost::optional<uint16_t> m_itemId;
+
+            std::set<std::weak_ptr<audio::Voice>, std::owner_less<std::weak_ptr<audio::Voice>>> m_sounds;
 
             void updateSounds();
 
+            void addToRoomIndex();
+
+            void removeFromRoomIndex();
+
+            void updateActiveItemsMembership();
+
         public:
             using Characteristics = uint8_t;
             static const constexpr Characteristics Intelligent = 0x02;
@@ -100,15 +110,10 @@ namespace engine
             const Characteristics m_characteristics;
             const int16_t m_darkness;
 
-            struct Lighting
-            {
-                glm::vec3 position;
-                float base;
-                float baseDiff;
-            };
-
-
-            Lighting m_lighting;
+            //! Resolved by updateLighting(), and uploaded to the entry read by the nodes bound with bindLighting()
+            render::ItemLighting::Light m_lighting;
+            //! The entry of this item in level::Level::m_itemLighting
+            const GLint m_lightIndex;
 
 
             enum class AnimCommandOpcode : uint16_t
@@ -134,7 +139,7 @@ namespace engine
                      int16_t darkness,
                      const loader::AnimatedModel& animatedModel);
 
-            virtual ~ItemNode() = default;
+            virtual ~ItemNode();
 
             void update() override;
 
@@ -172,6 +177,15 @@ namespace engine
 
             void setCurrentRoom(const loader::Room* newRoom);
 
+            const boost::optional<uint16_t>& getItemId() const noexcept
+            {
+                return m_itemId;
+            }
+
+
+            //! Adds the item to the item index of its current room, see loader::Room::items, and to the active items of the level.
+            void setItemId(uint16_t itemId);
+
             void applyTransform();
 
 
@@ -371,6 +385,18 @@ namespace engine
 
             void deactivate();
 
+
+            /**
+             * @brief Whether update() has any effect, see level::Level::m_activeItems.
+             *
+             * This is evaluated when the item is activated or deactivated, so it may only depend on
+             * whether the item is active.
+             */
+            virtual bool needsUpdate() const
+            {
+                return true;
+            }
+
             int getHorizontalSpeed()
             {
                 return m_horizontalSpeed;
@@ -405,7 +431,7 @@ namespace engine
             }
 
 
-            std::shared_ptr<audio::SourceHandle> playSoundEffect(int id);
+            std::shared_ptr<audio::Voice> playSoundEffect(int id);
 
 
             bool triggerPickUp()
@@ -474,23 +500,27 @@ namespace engine
                 }
 
                 float maxBrightness = 0;
-                const auto bboxCtr = m_position.position + getBoundingBox().getCenter();
+                const loader::Light* brightestLight = nullptr;
+                const auto bboxCtr = (m_position.position + getBoundingBox().getCenter()).toRenderSystem();
                 for( const auto& light : m_position.room->lights )
                 {
                     auto radiusSq = light.radius / 4096.0f;
                     radiusSq *= radiusSq;
 
-                    auto distanceSq = bboxCtr.distanceTo(light.position) / 4096.0f;
-                    distanceSq *= distanceSq;
+                    const auto d = (light.position.toRenderSystem() - bboxCtr) / 4096.0f;
+                    const auto distanceSq = glm::dot(d, d);
 
                     const auto lightBrightness = roomAmbient + radiusSq * light.getBrightness() / (radiusSq + distanceSq);
                     if( lightBrightness > maxBrightness )
                     {
                         maxBrightness = lightBrightness;
-                        m_lighting.position = light.position.toRenderSystem();
+                        brightestLight = &light;
                     }
                 }
 
+                if( brightestLight != nullptr )
+                    m_lighting.position = brightestLight->position.toRenderSystem();
+
                 m_lighting.base = (roomAmbient + maxBrightness) / 2;
                 m_lighting.baseDiff = (maxBrightness - m_lighting.base);
 
@@ -499,66 +529,8 @@ namespace engine
             }
 
 
-            static const ItemNode* findBaseItemNode(const gameplay::Node& node)
-            {
-                const ItemNode* item = nullptr;
-
-                auto n = &node;
-                while( true )
-                {
-                    item = dynamic_cast<const ItemNode*>(n);
-
-                    if( item != nullptr || n->getParent().expired() )
-                        break;
-
-                    n = n->getParent().lock().get();
-                }
-
-                return item;
-            }
-
-
-            static void lightBaseBinder(const gameplay::Node& node, gameplay::gl::Program::ActiveUniform& uniform)
-            {
-                const ItemNode* item = findBaseItemNode(node);
-
-                if( item == nullptr )
-                {
-                    uniform.set(1.0f);
-                    return;
-                }
-
-                uniform.set(item->m_lighting.base);
-            };
-
-
-            static void lightBaseDiffBinder(const gameplay::Node& node, gameplay::gl::Program::ActiveUniform& uniform)
-            {
-                const ItemNode* item = findBaseItemNode(node);
-
-                if( item == nullptr )
-                {
-                    uniform.set(1.0f);
-                    return;
-                }
-
-                uniform.set(item->m_lighting.baseDiff);
-            };
-
-
-            static void lightPositionBinder(const gameplay::Node& node, gameplay::gl::Program::ActiveUniform& uniform)
-            {
-                const ItemNode* item = findBaseItemNode(node);
-
-                if( item == nullptr )
-                {
-                    static const glm::vec3 invalidPos{std::numeric_limits<float>::quiet_NaN()};
-                    uniform.set(invalidPos);
-                    return;
-                }
-
-                uniform.set(item->m_lighting.position);
-            };
+            //! Makes @a node, i.e. this item or one of its bones, use the lighting of this item
+            void bindLighting(gameplay::Node& node) const;
 
         protected:
             bool updateActivationTimeout()
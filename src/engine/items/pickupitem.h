@@ -30,6 +30,12 @@ namespace engine
             }
 
 
+            bool needsUpdate() const override
+            {
+                return false;
+            }
+
+
             void onInteract(LaraNode& lara) override;
 
 
@@ -41,6 +41,12 @@ namespace engine
 
                 ItemNode::update();
             }
+
+
+            bool needsUpdate() const override
+            {
+                return m_isActive;
+            }
         };
     }
 }
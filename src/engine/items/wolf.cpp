@@ -35,14 +35,15 @@ namespace engine
             core::Angle rotationToMoveTarget = 0_deg;
             if( getHealth() > 0 )
             {
-                ai::LookAhead lookAhead(*this, 375);
+                auto lookAhead = getLookAhead(375);
 
                 if( lookAhead.laraAhead )
                 {
                     pitch = lookAhead.pivotAngleToLara;
                 }
 
-                getBrain().route.updateMood(getBrain(), lookAhead, *this, false, 0x2000);
+                if( isThinking() )
+                    getBrain().route.updateMood(getBrain(), lookAhead, *this, false, 0x2000);
                 rotationToMoveTarget = rotateTowardsMoveTarget(getBrain(), getBrain().jointRotation.Z);
                 switch( getCurrentState() )
                 {
@@ -121,11 +121,8 @@ namespace engine
                 case LaraStateId::Handstand: return std::make_unique<StateHandler_54>(lara);
                 case LaraStateId::OnWaterExit: return std::make_unique<StateHandler_55>(lara);
                 default:
-                    BOOST_LOG_TRIVIAL( error ) << "No state handler for state " << loader::toString(id);
-                    throw std::runtime_error("Unhandled state");
+                    return nullptr;
             }
-
-            return nullptr;
         }
 
 
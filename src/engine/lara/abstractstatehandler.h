@@ -38,6 +38,7 @@ namespace engine
             virtual void handleInput(CollisionInfo& collisionInfo) = 0;
 
 
+            //! Returns @c nullptr if there is no handler for the state.
             static std::unique_ptr<AbstractStateHandler> create(LaraStateId id, LaraNode& lara);
 
 
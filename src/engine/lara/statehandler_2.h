@@ -76,14 +76,14 @@ namespace engine
                 else if( getLevel().m_inputHandler->getInputState().zMovement == AxisMovement::Forward )
                 {
                     if( getLevel().m_inputHandler->getInputState().moveSlow )
-                        create(LaraStateId::WalkForward, getLara())->handleInput(collisionInfo);
+                        getLara().getStateHandler(LaraStateId::WalkForward).handleInput(collisionInfo);
                     else
-                        create(LaraStateId::RunForward, getLara())->handleInput(collisionInfo);
+                        getLara().getStateHandler(LaraStateId::RunForward).handleInput(collisionInfo);
                 }
                 else if( getLevel().m_inputHandler->getInputState().zMovement == AxisMovement::Backward )
                 {
                     if( getLevel().m_inputHandler->getInputState().moveSlow )
-                        create(LaraStateId::WalkBackward, getLara())->handleInput(collisionInfo);
+                        getLara().getStateHandler(LaraStateId::WalkBackward).handleInput(collisionInfo);
                     else
                         setTargetState(LaraStateId::RunBack);
                 }
@@ -7,7 +7,7 @@
 #include "items/block.h"
 #include "items/tallblock.h"
 
-#include <boost/range/adaptors.hpp>
+#include <algorithm>
 
 
 namespace
@@ -37,6 +37,13 @@ namespace
 
         // move all items over
         orig.node->swapChildren(alternate.node);
+        std::swap(orig.items, alternate.items);
+
+        // static meshes belong to the room geometry, so move them back; their instances are relative to the room
+        for( const auto& staticMesh : orig.staticMeshNodes )
+            orig.node->addChild(staticMesh.first);
+        for( const auto& staticMesh : alternate.staticMeshNodes )
+            alternate.node->addChild(staticMesh.first);
 
         // patch heights in the new room.
         // note that this is exactly the same code as above,
@@ -67,6 +74,7 @@ namespace
         }
 
         level.roomsAreSwapped = !level.roomsAreSwapped;
+        level.m_sectorCache->rebuild();
     }
 }
 
@@ -98,7 +106,7 @@ namespace engine
         collisionInfo.collisionRadius = 100; //!< @todo MAGICK 100
         collisionInfo.policyFlags = CollisionInfo::EnableSpaz | CollisionInfo::EnableBaddiePush;
 
-        lara::AbstractStateHandler::create(getCurrentAnimState(), *this)->handleInput(collisionInfo);
+        getStateHandler(getCurrentAnimState()).handleInput(collisionInfo);
 
         if( getLevel().m_cameraController->getCamOverrideType() != CamOverrideType::FreeLook )
         {
@@ -156,7 +164,7 @@ namespace engine
 
         testInteractions();
 
-        lara::AbstractStateHandler::create(getCurrentAnimState(), *this)->postprocessFrame(collisionInfo);
+        getStateHandler(getCurrentAnimState()).postprocessFrame(collisionInfo);
 
         updateFloorHeight(-381);
 
@@ -185,7 +193,7 @@ namespace engine
         collisionInfo.passableFloorDistanceBottom = loader::HeightLimit;
         collisionInfo.passableFloorDistanceTop = -400;
 
-        lara::AbstractStateHandler::create(getCurrentAnimState(), *this)->handleInput(collisionInfo);
+        getStateHandler(getCurrentAnimState()).handleInput(collisionInfo);
 
         // "slowly" revert rotations to zero
         if( getRotation().Z < -2_deg )
@@ -217,7 +225,7 @@ namespace engine
 
         testInteractions();
 
-        lara::AbstractStateHandler::create(getCurrentAnimState(), *this)->postprocessFrame(collisionInfo);
+        getStateHandler(getCurrentAnimState()).postprocessFrame(collisionInfo);
 
         updateFloorHeight(0);
         //! @todo update weapon state
@@ -243,7 +251,7 @@ namespace engine
 
         setCameraRotationX(-22_deg);
 
-        lara::AbstractStateHandler::create(getCurrentAnimState(), *this)->handleInput(collisionInfo);
+        getStateHandler(getCurrentAnimState()).handleInput(collisionInfo);
 
         // "slowly" revert rotations to zero
         if( getRotation().Z < 0_deg )
@@ -279,7 +287,7 @@ namespace engine
 
         testInteractions();
 
-        lara::AbstractStateHandler::create(getCurrentAnimState(), *this)->postprocessFrame(collisionInfo);
+        getStateHandler(getCurrentAnimState()).postprocessFrame(collisionInfo);
 
         updateFloorHeight(100);
         //! @todo Update weapon state
@@ -305,6 +313,26 @@ namespace engine
     LaraNode::~LaraNode() = default;
 
 
+    void LaraNode::createStateHandlers()
+    {
+        for( uint16_t id = 0; id <= static_cast<uint16_t>(LaraStateId::OnWaterExit); ++id )
+            m_stateHandlers.emplace_back(lara::AbstractStateHandler::create(static_cast<LaraStateId>(id), *this));
+    }
+
+
+    lara::AbstractStateHandler& LaraNode::getStateHandler(LaraStateId id) const
+    {
+        const auto idx = static_cast<size_t>(id);
+        if( idx >= m_stateHandlers.size() || m_stateHandlers[idx] == nullptr )
+        {
+            BOOST_LOG_TRIVIAL(error) << "No state handler for state " << loader::toString(id);
+            BOOST_THROW_EXCEPTION(std::runtime_error("Unhandled state"));
+        }
+
+        return *m_stateHandlers[idx];
+    }
+
+
     void LaraNode::update()
     {
         if( m_underwaterState == UnderwaterState::OnLand && getCurrentRoom()->isWaterRoom() )
@@ -431,7 +459,7 @@ namespace engine
         ++m_uvAnimTime;
         if( m_uvAnimTime >= UVAnimTime )
         {
-            getLevel().m_textureAnimator->updateCoordinates(getLevel().m_textureProxies);
+            getLevel().m_textureAnimator->update();
             m_uvAnimTime -= UVAnimTime;
         }
         // <<<<<<<<<<<<<<<<<
@@ -867,16 +895,18 @@ namespace engine
         if( m_health < 0 )
             return;
 
-        std::set<const loader::Room*> rooms;
-        rooms.insert(getCurrentRoom());
-        for( const loader::Portal& p : getCurrentRoom()->portals )
-            rooms.insert(&getLevel().m_rooms[p.adjoining_room]);
+        // the item indices of the rooms are disjoint, and sorting by id keeps the interaction order of the level data
+        m_interactionCandidates.assign(getCurrentRoom()->items.begin(), getCurrentRoom()->items.end());
+        for( const loader::Room* room : getCurrentRoom()->adjoiningRooms )
+            m_interactionCandidates.insert(m_interactionCandidates.end(), room->items.begin(), room->items.end());
 
-        for( const std::shared_ptr<ItemNode>& item : getLevel().m_itemNodes | boost::adaptors::map_values )
-        {
-            if( rooms.find(item->getCurrentRoom()) == rooms.end() )
-                continue;
+        std::sort(m_interactionCandidates.begin(), m_interactionCandidates.end(), [](const ItemNode* a, const ItemNode* b)
+                  {
+                      return *a->getItemId() < *b->getItemId();
+                  });
 
+        for( ItemNode* item : m_interactionCandidates )
+        {
             if( !item->m_flags2_20_collidable )
                 continue;
 
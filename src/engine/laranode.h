@@ -54,6 +54,8 @@ namespace engine
             setAnimIdGlobal(loader::AnimationId::STAY_IDLE);
             setTargetState(LaraStateId::Stop);
             setMovementAngle(getRotation().Y);
+
+            createStateHandlers();
         }
 
 
@@ -82,7 +84,15 @@ namespace engine
 
         void update() override;
 
+        //! The state handlers are stateless, so they are created once and shared by all ticks.
+        lara::AbstractStateHandler& getStateHandler(LaraStateId id) const;
+
     private:
+        //! Indexed by state id; @c nullptr for states without handler
+        std::vector<std::unique_ptr<lara::AbstractStateHandler>> m_stateHandlers;
+
+        void createStateHandlers();
+
         void handleLaraStateOnLand();
 
         void handleLaraStateDiving();
@@ -91,6 +101,9 @@ namespace engine
 
         void testInteractions();
 
+        //! Scratch buffer of testInteractions()
+        std::vector<ItemNode*> m_interactionCandidates;
+
         //! @brief If "none", we are not allowed to dive until the "Dive" action key is released
         //! @remarks This happens e.g. just after dive-to-swim transition, when players still
         //!          keep the "Dive Forward" action key pressed; in this case, you usually won't go
@@ -166,6 +166,51 @@ namespace engine
             updatePoseKeyframe( framePair );
         else
             updatePoseInterpolated( framePair );
+
+        updateSkin();
+    }
+
+
+    void SkeletalModelNode::updateSkin()
+    {
+        m_bonePalette.clear();
+        for( const auto& bone : getChildren() )
+            m_bonePalette.emplace_back( bone->getLocalMatrix() );
+
+        // bone meshes may be swapped at any time, e.g. when Lara draws her weapons
+        bool meshesChanged = m_skinnedBoneDrawables.size() != getChildCount();
+        for( size_t i = 0; i < m_skinnedBoneDrawables.size() && !meshesChanged; ++i )
+            meshesChanged = m_skinnedBoneDrawables[i] != getChild( i )->getDrawable();
+
+        if( !meshesChanged )
+            return;
+
+        m_skinnedBoneDrawables.clear();
+        for( const auto& bone : getChildren() )
+            m_skinnedBoneDrawables.emplace_back( bone->getDrawable() );
+
+        const auto skinnedModel = m_level->getSkinnedModel( m_skinnedBoneDrawables );
+        setDrawable( skinnedModel );
+
+        // fall back to drawing each bone on its own if the meshes can't be merged
+        for( const auto& bone : getChildren() )
+            bone->setEnabled( skinnedModel == nullptr );
+    }
+
+
+    void SkeletalModelNode::bonePaletteBinder(const gameplay::Node& node, gameplay::gl::Program::ActiveUniform& uniform)
+    {
+        const auto skeleton = dynamic_cast<const SkeletalModelNode*>(&node);
+
+        if( skeleton == nullptr || skeleton->m_bonePalette.empty() )
+        {
+            static const glm::mat4 identity{1.0f};
+            uniform.set( identity );
+            return;
+        }
+
+        BOOST_ASSERT( skeleton->m_bonePalette.size() <= MaxSkinnedBones );
+        uniform.set( skeleton->m_bonePalette.data(), gsl::narrow<GLsizei>( skeleton->m_bonePalette.size() ) );
     }
 
 
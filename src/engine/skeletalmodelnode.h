@@ -47,9 +47,19 @@ namespace engine
     };
 
 
+    /**
+     * @brief An animated model with one child node per bone.
+     *
+     * The bone nodes hold the pose and the mesh of each bone.  When possible, the bone meshes are
+     * merged into a single skinned model drawn by this node, with the pose uploaded as a matrix
+     * palette, so the bone nodes themselves are disabled.
+     */
     class SkeletalModelNode : public gameplay::Node
     {
     public:
+        //! Size of the bone palette in the skinning shaders
+        static constexpr size_t MaxSkinnedBones = 32;
+
         explicit SkeletalModelNode(const std::string& id,
                                    const gsl::not_null<const level::Level*>& lvl,
                                    const loader::AnimatedModel& mdl);
@@ -121,6 +131,9 @@ namespace engine
 
         virtual void update() = 0;
 
+
+        static void bonePaletteBinder(const gameplay::Node& node, gameplay::gl::Program::ActiveUniform& uniform);
+
     protected:
         bool handleStateTransitions();
 
@@ -135,6 +148,10 @@ namespace engine
         const loader::AnimatedModel& m_model;
         uint16_t m_targetState = 0;
         std::vector<glm::mat4> m_bonePatches;
+        //! The bone matrices of the current pose, relative to this node
+        std::vector<glm::mat4> m_bonePalette;
+        //! The bone meshes the current skinned model was built from
+        std::vector<std::shared_ptr<gameplay::Drawable>> m_skinnedBoneDrawables;
 
 #pragma pack(push, 1)
 
@@ -181,6 +198,8 @@ namespace engine
 
         void updatePoseInterpolated(const InterpolationInfo& framepair);
 
+        void updateSkin();
+
         int getStartFrame() const;
 
         int getEndFrame() const;
@@ -1,6 +1,8 @@
 #include "level.h"
 
 #include "engine/laranode.h"
+#include "meshtable.h"
+#include "render/instancednode.h"
 #include "render/textureanimator.h"
 #include "tr1level.h"
 #include "tr2level.h"
@@ -27,6 +29,7 @@
 #include "engine/items/wolf.h"
 
 #include "loader/converter.h"
+#include "util/threadpool.h"
 
 #include "util/md5.h"
 
@@ -36,6 +39,9 @@
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 
+#include <algorithm>
+#include <chrono>
+
 using namespace level;
 
 
@@ -51,6 +57,8 @@ Level::~Level() = default;
 /// \brief reads the mesh data.
 void Level::readMeshData(loader::io::SDLReader& reader)
 {
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
     uint32_t meshDataWords = reader.readU32();
     const auto basePos = reader.tell();
 
@@ -61,30 +69,22 @@ void Level::readMeshData(loader::io::SDLReader& reader)
     const auto endPos = reader.tell();
 
     m_meshes.clear();
-
-    size_t meshDataPos = 0;
-    for( size_t i = 0; i < m_meshIndices.size(); i++ )
+    buildMeshTable(m_meshIndices, [this, &reader, basePos, meshDataSize](uint32_t offset)
     {
-        std::replace(m_meshIndices.begin(), m_meshIndices.end(), meshDataPos, i);
-
-        reader.seek(basePos + std::streamoff(meshDataPos));
+        BOOST_ASSERT( offset < meshDataSize );
+        reader.seek(basePos + std::streamoff(offset));
 
         if( gameToEngine(m_gameVersion) >= Engine::TR4 )
             m_meshes.emplace_back(*loader::Mesh::readTr4(reader));
         else
             m_meshes.emplace_back(*loader::Mesh::readTr1(reader));
-
-        for( size_t j = 0; j < m_meshIndices.size(); j++ )
-        {
-            if( m_meshIndices[j] > meshDataPos )
-            {
-                meshDataPos = m_meshIndices[j];
-                break;
-            }
-        }
-    }
+    });
 
     reader.seek(endPos);
+
+    const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - startTime);
+    BOOST_LOG_TRIVIAL(info) << "Read " << m_meshes.size() << " meshes for " << m_meshIndices.size() << " mesh pointers in "
+                            << duration.count() << "us";
 }
 
 
@@ -316,25 +316,68 @@ boost::optional<size_t> Level::findSpriteSequenceForType(uint32_t type) const
 }
 
 
-std::vector<std::shared_ptr<gameplay::gl::Texture> > Level::createTextures(loader::trx::Glidos* glidos, const boost::filesystem::path& lvlName)
+std::shared_ptr<gameplay::gl::Texture> Level::createTextures(loader::trx::Glidos* glidos, const boost::filesystem::path& lvlName)
 {
     BOOST_ASSERT( !m_textures.empty() );
-    std::vector<std::shared_ptr<gameplay::gl::Texture>> textures;
-    for( size_t i = 0; i < m_textures.size(); ++i )
+
+    const auto startTime = std::chrono::high_resolution_clock::now();
+
+    // Upgrading the textures happens on the pool; only the uploads need to be done here on the GL thread.
+    util::ThreadPool pool;
+    std::vector<std::future<std::shared_ptr<gameplay::ext::Image<gameplay::gl::RGBA8>>>> images;
+    images.reserve(m_textures.size());
+    for( const auto& texture : m_textures )
+    {
+        images.emplace_back(texture.toImage(glidos, lvlName, pool));
+    }
+
+    // All pages are layers of a single array texture, so that geometry using different pages
+    // can be drawn without re-binding textures.
+    std::shared_ptr<gameplay::gl::Texture> textures;
+    for( size_t i = 0; i < images.size(); ++i )
     {
-        loader::DWordTexture& texture = m_textures[i];
-        textures.emplace_back(texture.toTexture(glidos, lvlName));
+        const auto img = images[i].get();
+        if( textures == nullptr )
+        {
+            textures = std::make_shared<gameplay::gl::Texture>(GL_TEXTURE_2D_ARRAY, "Level textures");
+            textures->image3D<gameplay::gl::RGBA8>(img->getWidth(), img->getHeight(), gsl::narrow<GLint>(images.size()), true);
+        }
+        else if( img->getWidth() != textures->getWidth() || img->getHeight() != textures->getHeight() )
+        {
+            BOOST_LOG_TRIVIAL(error) << "Texture " << i << " has size " << img->getWidth() << "x" << img->getHeight()
+                                     << ", expected " << textures->getWidth() << "x" << textures->getHeight();
+            BOOST_THROW_EXCEPTION(std::runtime_error("All level textures must have the same size"));
+        }
+
+        textures->subImage3D(gsl::narrow<GLint>(i), img->getData());
+
+        if( glidos != nullptr )
+            BOOST_LOG_TRIVIAL(info) << "Texture " << i + 1 << "/" << images.size() << " ready";
     }
+
+    textures->generateMipmaps();
+
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - startTime);
+    BOOST_LOG_TRIVIAL(info) << "Created " << images.size() << " texture layers in " << duration.count() << "ms using "
+                            << pool.getThreadCount() << " threads";
+
     return textures;
 }
 
 
+uint16_t Level::getTextureIndexMask() const
+{
+    return gameToEngine(m_gameVersion) == Engine::TR4 ? loader::TextureIndexMaskTr4 : loader::TextureIndexMask;
+}
+
+
 std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>
-Level::createMaterials(const std::vector<std::shared_ptr<gameplay::gl::Texture> >& textures,
+Level::createMaterials(const std::shared_ptr<gameplay::gl::Texture>& textures,
                        const std::shared_ptr<gameplay::ShaderProgram>& shader)
 {
-    const auto texMask = gameToEngine(m_gameVersion) == Engine::TR4 ? loader::TextureIndexMaskTr4
-                             : loader::TextureIndexMask;
+    // The texture page is selected per vertex, so materials only differ by their blending mode;
+    // sharing them lets the geometry builders merge parts using the same material.
+    std::map<loader::BlendingMode, std::shared_ptr<gameplay::Material>> blendingMaterials;
     std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>> materials;
     for( loader::TextureLayoutProxy& proxy : m_textureProxies )
     {
@@ -342,12 +385,85 @@ Level::createMaterials(const std::vector<std::shared_ptr<gameplay::gl::Texture>
         if( materials.find(key) != materials.end() )
             continue;
 
-        materials[key] = proxy.createMaterial(textures[key.tileAndFlag & texMask], shader);
+        auto& material = blendingMaterials[key.blendingMode];
+        if( material == nullptr )
+        {
+            material = proxy.createMaterial(textures, shader);
+            m_textureAnimator->bind(*material);
+            render::InstancedNode::bindDefaults(*material);
+        }
+
+        materials[key] = material;
     }
     return materials;
 }
 
 
+std::shared_ptr<gameplay::Model> Level::getSkinnedModel(const std::vector<std::shared_ptr<gameplay::Drawable>>& boneDrawables) const
+{
+    if( boneDrawables.empty() || boneDrawables.size() > engine::SkeletalModelNode::MaxSkinnedBones )
+        return nullptr;
+
+    std::vector<size_t> meshIndices;
+    meshIndices.reserve(boneDrawables.size());
+    for( const auto& drawable : boneDrawables )
+    {
+        const auto it = std::find_if(m_models.begin(), m_models.end(), [&drawable](const std::shared_ptr<gameplay::Model>& model)
+                                     {
+                                         return model.get() == drawable.get();
+                                     });
+        if( drawable == nullptr || it == m_models.end() )
+            return nullptr;
+
+        meshIndices.emplace_back(std::distance(m_models.begin(), it));
+    }
+
+    {
+        auto it = m_skinnedModels.find(meshIndices);
+        if( it != m_skinnedModels.end() )
+            return it->second;
+    }
+
+    // check if the meshes can be merged; a failed check is cached, too
+    std::shared_ptr<gameplay::Model> result;
+    const bool withNormals = !m_meshes[meshIndices[0]].normals.empty();
+    size_t vertexCount = 0;
+    bool canMerge = true;
+    for( auto idx : meshIndices )
+    {
+        const loader::Mesh& mesh = m_meshes[idx];
+        canMerge &= m_overriddenModels.find(idx) == m_overriddenModels.end();
+        canMerge &= mesh.normals.empty() != withNormals;
+        vertexCount += 4 * (mesh.textured_rectangles.size() + mesh.colored_rectangles.size())
+                       + 3 * (mesh.textured_triangles.size() + mesh.colored_triangles.size());
+    }
+    canMerge &= vertexCount <= std::numeric_limits<uint16_t>::max();
+
+    if( canMerge )
+    {
+        loader::Mesh::ModelBuilder builder{
+            withNormals,
+            false,
+            m_textureProxies,
+            m_skinnedMaterials,
+            getTextureIndexMask(),
+            m_skinnedColorMaterial,
+            *m_palette,
+            *m_textureAnimator,
+            "skinned"
+        };
+
+        for( size_t i = 0; i < meshIndices.size(); ++i )
+            builder.append(m_meshes[meshIndices[i]], static_cast<float>(i));
+
+        result = builder.finalize();
+    }
+
+    m_skinnedModels.emplace(std::move(meshIndices), result);
+    return result;
+}
+
+
 namespace
 {
     uint16_t mapSpriteToModel(uint16_t id)
@@ -480,6 +596,7 @@ engine::LaraNode* Level::createItems()
 
             m_itemNodes[id] = modelNode;
             room.node->addChild(modelNode);
+            modelNode->setItemId(gsl::narrow<uint16_t>(id));
 
             modelNode->setLocalMatrix(glm::translate(glm::mat4{1.0f}, item.position.toRenderSystem()));
 
@@ -564,6 +681,8 @@ std::shared_ptr<T> Level::createSkeletalModel(size_t id,
         auto node = std::make_shared<gameplay::Node>(
             skeletalModel->getId() + "/bone:" + boost::lexical_cast<std::string>(boneIndex));
         node->setDrawable(m_models[m_meshIndices[model.firstMesh + boneIndex]]);
+        // the bones are only drawn on their own if the model can't be skinned
+        skeletalModel->bindLighting(*node);
         skeletalModel->addChild(node);
     }
 
@@ -742,53 +861,85 @@ YAML::Node parseCommandSequence(const uint16_t*& rawFloorData, const engine::flo
 void Level::setUpRendering(gameplay::Game* game,
                            const boost::filesystem::path& assetPath,
                            const boost::filesystem::path& lvlName,
-                           const std::unique_ptr<loader::trx::Glidos>& glidos)
+                           const std::unique_ptr<loader::trx::Glidos>& glidos,
+                           bool exportAssets)
 {
     m_inputHandler = std::make_unique<engine::InputHandler>(game->getWindow());
 
     auto textures = createTextures(glidos.get(), lvlName);
+    // bound by createMaterials()
+    m_textureAnimator = std::make_shared<render::TextureAnimator>(m_animatedTextures, m_textureProxies, getTextureIndexMask());
 
-    auto texturedShader = gameplay::ShaderProgram::createFromFile("shaders/textured_2.vert", "shaders/textured_2.frag");
+    auto texturedShader = gameplay::ShaderProgram::createFromFile("shaders/textured_2.vert", "shaders/textured_2.frag",
+                                                                  {"TEXTURE_ARRAY"});
     std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>> materials = createMaterials(
         textures, texturedShader);
 
-    std::shared_ptr<gameplay::Material> colorMaterial = std::make_shared<gameplay::Material>("shaders/colored_2.vert",
-                                                                                             "shaders/colored_2.frag");
-    colorMaterial->initStateBlockDefaults();
-    colorMaterial->getParameter("u_worldViewProjectionMatrix")->bindWorldViewProjectionMatrix();
-    colorMaterial->getParameter("u_modelMatrix")->bindModelMatrix();
-    colorMaterial->getParameter("u_baseLight")->bind(&engine::items::ItemNode::lightBaseBinder);
-    colorMaterial->getParameter("u_baseLightDiff")->bind(&engine::items::ItemNode::lightBaseDiffBinder);
-    colorMaterial->getParameter("u_lightPosition")->bind(&engine::items::ItemNode::lightPositionBinder);
-
-    m_textureAnimator = std::make_shared<render::TextureAnimator>(m_animatedTextures);
+    const auto createColorMaterial = [](const std::vector<std::string>& defines)
+    {
+        auto material = std::make_shared<gameplay::Material>("shaders/colored_2.vert", "shaders/colored_2.frag", defines);
+        material->initStateBlockDefaults();
+        material->getParameter("u_modelMatrix")->bindModelMatrix();
+        render::ItemLighting::bindDefaults(*material);
+        render::InstancedNode::bindDefaults(*material);
+        return material;
+    };
+
+    std::shared_ptr<gameplay::Material> colorMaterial = createColorMaterial({});
+
+    // skeletal models are drawn as a single skinned mesh, see getSkinnedModel()
+    auto skinnedShader = gameplay::ShaderProgram::createFromFile("shaders/textured_2.vert", "shaders/textured_2.frag",
+                                                                 {"TEXTURE_ARRAY", "SKINNED"});
+    m_skinnedMaterials = createMaterials(textures, skinnedShader);
+    for( const auto& material : m_skinnedMaterials | boost::adaptors::map_values )
+        material->getParameter("u_bones")->bind(&engine::SkeletalModelNode::bonePaletteBinder);
+
+    m_skinnedColorMaterial = createColorMaterial({"SKINNED"});
+    m_skinnedColorMaterial->getParameter("u_bones")->bind(&engine::SkeletalModelNode::bonePaletteBinder);
 
     for( size_t i = 0; i < m_meshes.size(); ++i )
     {
-        m_models.emplace_back(m_meshes[i].createModel(m_textureProxies, materials, colorMaterial, *m_palette,
-                                                      *m_textureAnimator));
+        m_models.emplace_back(m_meshes[i].createModel(m_textureProxies, materials, getTextureIndexMask(), colorMaterial,
+                                                      *m_palette, *m_textureAnimator));
     }
 
     game->getScene()->setActiveCamera(
         std::make_shared<gameplay::Camera>(glm::radians(80.0f), game->getAspectRatio(), 10, 20480));
 
     auto waterTexturedShader = gameplay::ShaderProgram::createFromFile("shaders/textured_2.vert", "shaders/textured_2.frag",
-                                                                       {"WATER"});
+                                                                       {"WATER", "TEXTURE_ARRAY"});
     std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>> waterMaterials = createMaterials(
         textures, waterTexturedShader);
 
+    size_t roomFaceVertexCount = 0;
+    size_t roomVertexCount = 0;
     for( size_t i = 0; i < m_rooms.size(); ++i )
     {
-        m_rooms[i].createSceneNode(game, i, *this, textures, materials, waterMaterials, m_models, *m_textureAnimator);
+        m_rooms[i].createSceneNode(game, i, *this, textures, materials, waterMaterials, m_models, *m_textureAnimator, roomFaceVertexCount);
         game->getScene()->addNode(m_rooms[i].node);
+
+        for( const auto& mesh : std::static_pointer_cast<gameplay::Model>(m_rooms[i].node->getDrawable())->getMeshes() )
+            roomVertexCount += mesh->getBuffer(0).getVertexCount();
     }
+    BOOST_LOG_TRIVIAL(info) << "Room geometry: " << roomVertexCount << " vertices, deduplicated from " << roomFaceVertexCount
+                            << " face vertices";
 
     {
+        // Override models come with their own textures, one per page
+        auto overrideShader = gameplay::ShaderProgram::createFromFile("shaders/textured_2.vert", "shaders/textured_2.frag");
+        auto waterOverrideShader = gameplay::ShaderProgram::createFromFile("shaders/textured_2.vert", "shaders/textured_2.frag",
+                                                                           {"WATER"});
+
         loader::Converter objWriter{assetPath / lvlName};
 
-        for( size_t i = 0; i < m_textures.size(); ++i )
+        if( exportAssets )
         {
-            objWriter.write(m_textures[i].toImage(nullptr, {}), i);
+            m_assetExporter = std::make_unique<loader::AssetExporter>(assetPath / lvlName);
+
+            for( size_t i = 0; i < m_textures.size(); ++i )
+            {
+                m_assetExporter->write(m_textures[i], i);
+            }
         }
 
         for( const auto& trModel : m_animatedModels )
@@ -798,13 +949,12 @@ void Level::setUpRendering(gameplay::Game* game,
                 BOOST_ASSERT(trModel->firstMesh + boneIndex < m_meshIndices.size());
                 BOOST_ASSERT(m_meshIndices[trModel->firstMesh + boneIndex] < m_models.size());
 
-                std::string filename = "model_" + std::to_string(trModel->type) + "_" + std::to_string(boneIndex) + ".dae";
-                if( !objWriter.exists(filename) )
+                std::string filename;
+                if( m_assetExporter != nullptr )
                 {
-                    BOOST_LOG_TRIVIAL(info) << "Saving model " << filename;
-
+                    filename = "model_" + std::to_string(trModel->type) + "_" + std::to_string(boneIndex) + ".dae";
                     const auto& model = m_models[m_meshIndices[trModel->firstMesh + boneIndex]];
-                    objWriter.write(model, filename, materials, {}, glm::vec3(0.8f));
+                    m_assetExporter->write(model, filename, m_sourceHash, materials, {}, glm::vec3(0.8f));
                 }
 
                 filename = "model_override_" + std::to_string(trModel->type) + "_" + std::to_string(boneIndex) + ".dae";
@@ -812,7 +962,8 @@ void Level::setUpRendering(gameplay::Game* game,
                 {
                     BOOST_LOG_TRIVIAL(info) << "Loading override model " << filename;
 
-                    m_models[m_meshIndices[trModel->firstMesh + boneIndex]] = objWriter.readModel(filename, texturedShader, glm::vec3(0.8f));
+                    m_models[m_meshIndices[trModel->firstMesh + boneIndex]] = objWriter.readModel(filename, overrideShader, glm::vec3(0.8f));
+                    m_overriddenModels.insert(m_meshIndices[trModel->firstMesh + boneIndex]);
                 }
             }
         }
@@ -821,78 +972,78 @@ void Level::setUpRendering(gameplay::Game* game,
         {
             auto& room = m_rooms[i];
 
-            std::string filename = "room_" + std::to_string(i) + ".dae";
-            if( !objWriter.exists(filename) )
+            std::string filename;
+            if( m_assetExporter != nullptr )
             {
-                BOOST_LOG_TRIVIAL(info) << "Saving room model " << filename;
-
+                filename = "room_" + std::to_string(i) + ".dae";
                 const auto drawable = room.node->getDrawable();
                 const auto model = std::dynamic_pointer_cast<gameplay::Model>(drawable);
                 BOOST_ASSERT(model != nullptr);
-                objWriter.write(model, filename, materials, waterMaterials, glm::vec3{room.getAmbientBrightness()});
+                m_assetExporter->write(model, filename, m_sourceHash, materials, waterMaterials, glm::vec3{room.getAmbientBrightness()});
 
                 filename = "room_" + std::to_string(i) + ".yaml";
-                BOOST_LOG_TRIVIAL(info) << "Saving floor data to " << filename;
-
-                YAML::Node floorDataTree;
-                for( size_t x = 0; x < room.sectorCountX; ++x )
+                if( !m_assetExporter->isUpToDate(filename, m_sourceHash) )
                 {
-                    for( size_t z = 0; z < room.sectorCountZ; ++z )
+                    YAML::Node floorDataTree;
+                    for( size_t x = 0; x < room.sectorCountX; ++x )
                     {
-                        const gsl::not_null<const loader::Sector*> sector = room.getSectorByIndex(gsl::narrow<int>(x), gsl::narrow<int>(z));
-                        YAML::Node sectorTree;
-                        sectorTree["position"]["x"] = x;
-                        sectorTree["position"]["z"] = z;
-                        if( sector->floorHeight != -127 )
-                            sectorTree["layout"]["floor"] = sector->floorHeight * loader::QuarterSectorSize - room.position.Y;
-                        if( sector->ceilingHeight != -127 )
-                            sectorTree["layout"]["ceiling"] = sector->ceilingHeight * loader::QuarterSectorSize - room.position.Y;
-                        if( sector->roomBelow != 0xff )
-                            sectorTree["relations"]["roomBelow"] = int(sector->roomBelow);
-                        if( sector->roomAbove != 0xff )
-                            sectorTree["relations"]["roomAbove"] = int(sector->roomAbove);
-                        if( sector->boxIndex != 0xffff )
-                            sectorTree["relations"]["box"] = sector->boxIndex;
-
-                        const uint16_t* rawFloorData = &m_floorData[sector->floorDataIndex];
-                        while( true )
+                        for( size_t z = 0; z < room.sectorCountZ; ++z )
                         {
-                            const engine::floordata::FloorDataChunk chunkHeader{*rawFloorData++};
-                            switch( chunkHeader.type )
+                            const gsl::not_null<const loader::Sector*> sector = room.getSectorByIndex(gsl::narrow<int>(x), gsl::narrow<int>(z));
+                            YAML::Node sectorTree;
+                            sectorTree["position"]["x"] = x;
+                            sectorTree["position"]["z"] = z;
+                            if( sector->floorHeight != -127 )
+                                sectorTree["layout"]["floor"] = sector->floorHeight * loader::QuarterSectorSize - room.position.Y;
+                            if( sector->ceilingHeight != -127 )
+                                sectorTree["layout"]["ceiling"] = sector->ceilingHeight * loader::QuarterSectorSize - room.position.Y;
+                            if( sector->roomBelow != 0xff )
+                                sectorTree["relations"]["roomBelow"] = int(sector->roomBelow);
+                            if( sector->roomAbove != 0xff )
+                                sectorTree["relations"]["roomAbove"] = int(sector->roomAbove);
+                            if( sector->boxIndex != 0xffff )
+                                sectorTree["relations"]["box"] = sector->boxIndex;
+
+                            const uint16_t* rawFloorData = &m_floorData[sector->floorDataIndex];
+                            while( true )
                             {
-                                case engine::floordata::FloorDataChunkType::FloorSlant:
-                                    sectorTree["layout"]["floorSlant"]["x"] = gsl::narrow_cast<int8_t>(*rawFloorData & 0xff) + 0;
-                                    sectorTree["layout"]["floorSlant"]["z"] = gsl::narrow_cast<int8_t>((*rawFloorData >> 8) & 0xff) + 0;
-                                    ++rawFloorData;
-                                    break;
-                                case engine::floordata::FloorDataChunkType::CeilingSlant:
-                                    sectorTree["layout"]["ceilingSlant"]["x"] = gsl::narrow_cast<int8_t>(*rawFloorData & 0xff) + 0;
-                                    sectorTree["layout"]["ceilingSlant"]["z"] = gsl::narrow_cast<int8_t>((*rawFloorData >> 8) & 0xff) + 0;
-                                    ++rawFloorData;
-                                    break;
-                                case engine::floordata::FloorDataChunkType::PortalSector:
-                                    sectorTree["relations"]["portalToRoom"] = (*rawFloorData & 0xff);
-                                    ++rawFloorData;
-                                    break;
-                                case engine::floordata::FloorDataChunkType::Death:
-                                    sectorTree["characteristics"].push_back("deadly");
-                                    break;
-                                case engine::floordata::FloorDataChunkType::CommandSequence:
-                                    sectorTree["sequences"].push_back(parseCommandSequence(rawFloorData, chunkHeader.sequenceCondition));
-                                    break;
-                                default:
+                                const engine::floordata::FloorDataChunk chunkHeader{*rawFloorData++};
+                                switch( chunkHeader.type )
+                                {
+                                    case engine::floordata::FloorDataChunkType::FloorSlant:
+                                        sectorTree["layout"]["floorSlant"]["x"] = gsl::narrow_cast<int8_t>(*rawFloorData & 0xff) + 0;
+                                        sectorTree["layout"]["floorSlant"]["z"] = gsl::narrow_cast<int8_t>((*rawFloorData >> 8) & 0xff) + 0;
+                                        ++rawFloorData;
+                                        break;
+                                    case engine::floordata::FloorDataChunkType::CeilingSlant:
+                                        sectorTree["layout"]["ceilingSlant"]["x"] = gsl::narrow_cast<int8_t>(*rawFloorData & 0xff) + 0;
+                                        sectorTree["layout"]["ceilingSlant"]["z"] = gsl::narrow_cast<int8_t>((*rawFloorData >> 8) & 0xff) + 0;
+                                        ++rawFloorData;
+                                        break;
+                                    case engine::floordata::FloorDataChunkType::PortalSector:
+                                        sectorTree["relations"]["portalToRoom"] = (*rawFloorData & 0xff);
+                                        ++rawFloorData;
+                                        break;
+                                    case engine::floordata::FloorDataChunkType::Death:
+                                        sectorTree["characteristics"].push_back("deadly");
+                                        break;
+                                    case engine::floordata::FloorDataChunkType::CommandSequence:
+                                        sectorTree["sequences"].push_back(parseCommandSequence(rawFloorData, chunkHeader.sequenceCondition));
+                                        break;
+                                    default:
+                                        break;
+                                }
+                                if( chunkHeader.isLast )
                                     break;
                             }
-                            if( chunkHeader.isLast )
-                                break;
-                        }
 
-                        if( sectorTree.size() > 2 ) // only emit if we have more information than x/y coordinates
-                            floorDataTree["sectors"].push_back(sectorTree);
+                            if( sectorTree.size() > 2 ) // only emit if we have more information than x/y coordinates
+                                floorDataTree["sectors"].push_back(sectorTree);
+                        }
                     }
-                }
 
-                objWriter.write(filename, floorDataTree);
+                    m_assetExporter->write(filename, m_sourceHash, floorDataTree);
+                }
             }
 
             filename = "room_override_" + std::to_string(i) + ".dae";
@@ -903,25 +1054,47 @@ void Level::setUpRendering(gameplay::Game* game,
 
             room.node->setDrawable(nullptr);
 
-            auto model = objWriter.readModel(filename, room.isWaterRoom() ? waterTexturedShader : texturedShader, glm::vec3(room.ambientDarkness / 8191.0f));
+            auto model = objWriter.readModel(filename, room.isWaterRoom() ? waterOverrideShader : overrideShader, glm::vec3(room.ambientDarkness / 8191.0f));
             room.node->setDrawable(model);
         }
 
-        BOOST_LOG_TRIVIAL(info) << "Saving full level to _level.dae";
-        objWriter.write(m_rooms, m_boxes, "_level.dae", materials, waterMaterials);
+        if( m_assetExporter != nullptr )
+            m_assetExporter->write(m_rooms, m_boxes, "_level.dae", m_sourceHash, materials, waterMaterials);
+    }
+
+    m_sectorCache = std::make_unique<engine::floordata::SectorCache>(*this);
+    m_routeCache = std::make_unique<engine::ai::RouteCache>(*this);
+
+    for( loader::Room& room : m_rooms )
+    {
+        room.adjoiningRooms.clear();
+        for( const loader::Portal& portal : room.portals )
+        {
+            BOOST_ASSERT(portal.adjoining_room < m_rooms.size());
+            const loader::Room* adjoiningRoom = &m_rooms[portal.adjoining_room];
+            if( adjoiningRoom != &room
+                && std::find(room.adjoiningRooms.begin(), room.adjoiningRooms.end(), adjoiningRoom) == room.adjoiningRooms.end() )
+            {
+                room.adjoiningRooms.emplace_back(adjoiningRoom);
+            }
+        }
     }
 
+    m_itemLighting = std::make_unique<render::ItemLighting>();
     m_lara = createItems();
     if( m_lara == nullptr )
         return;
 
+    m_aiScheduler = std::make_unique<engine::ai::Scheduler>(*this);
+
     m_cameraController = new engine::CameraController(this, m_lara, game->getScene()->getActiveCamera());
 
     for( const loader::SoundSource& src : m_soundSources )
     {
+        // the voice manager keeps the ambience alive and virtualises it while out of range
         auto handle = playSound(src.sound_id, src.position.toRenderSystem());
-        handle->setLooping(true);
-        m_audioDev.registerSource(handle);
+        if( handle != nullptr )
+            handle->setLooping(true);
     }
 }
 
@@ -978,7 +1151,7 @@ gsl::not_null<const loader::Sector*> Level::findRealFloorSector(const core::TRCo
         sector = (*room)->findFloorSectorWithClampedIndex((position.X - (*room)->position.X) / loader::SectorSize,
                                                           (position.Z - (*room)->position.Z) / loader::SectorSize);
         Expects( sector != nullptr );
-        const auto portalTarget = engine::floordata::getPortalTarget(m_floorData, sector->floorDataIndex);
+        const auto portalTarget = m_sectorCache->get(sector).portalTarget;
         if( !portalTarget )
         {
             break;
@@ -1023,7 +1196,7 @@ gsl::not_null<const loader::Room*> Level::findRoomForPosition(const core::TRCoor
             gsl::narrow_cast<int>(position.X - room->position.X) / loader::SectorSize,
             gsl::narrow_cast<int>(position.Z - room->position.Z) / loader::SectorSize);
         Expects( sector != nullptr );
-        const auto portalTarget = engine::floordata::getPortalTarget(m_floorData, sector->floorDataIndex);
+        const auto portalTarget = m_sectorCache->get(sector).portalTarget;
         if( !portalTarget )
         {
             break;
@@ -1059,6 +1232,29 @@ gsl::not_null<const loader::Room*> Level::findRoomForPosition(const core::TRCoor
 }
 
 
+void Level::updateItems()
+{
+    // updating an item may (de)activate others, so look up the position of the next item id each time
+    for( auto it = m_activeItems.begin(); it != m_activeItems.end(); )
+    {
+        const auto item = *it;
+        if( item != m_lara ) // Lara is special and needs to be updated last
+            item->update();
+
+        it = std::upper_bound(m_activeItems.begin(), m_activeItems.end(), *item->getItemId(),
+                              [](uint16_t id, const engine::items::ItemNode* b)
+                              {
+                                  return id < *b->getItemId();
+                              });
+    }
+
+    for( const std::shared_ptr<engine::items::ItemNode>& item : m_dynamicItems )
+    {
+        item->update();
+    }
+}
+
+
 engine::items::ItemNode* Level::getItemController(uint16_t id) const
 {
     auto it = m_itemNodes.find(id);
@@ -1292,17 +1488,21 @@ void Level::stopCdTrack(uint16_t trackId)
 
 void Level::playStream(uint16_t trackId)
 {
-    static constexpr size_t DefaultBufferSize = 16384;
+    // smaller buffers are fine, as decoding happens ahead of playback on the stream's own thread
+    static constexpr size_t DefaultBufferSize = 8192;
+    static constexpr size_t DefaultBufferCount = 6;
 
     m_audioDev.removeStream(m_cdStream);
     m_cdStream.reset();
 
-    if( boost::filesystem::is_regular_file("data/tr1/audio/CDAUDIO.WAD") )
-        m_cdStream = std::make_unique<audio::Stream>(
-            std::make_unique<audio::WadStreamSource>("data/tr1/audio/CDAUDIO.WAD", trackId), DefaultBufferSize);
-    else
-        m_cdStream = std::make_unique<audio::Stream>(std::make_unique<audio::SndfileStreamSource>(
-                                                         (boost::format("data/tr1/audio/%03d.ogg") % trackId).str()), DefaultBufferSize);
+    m_cdStream = std::make_shared<audio::Stream>(
+        [trackId]() -> std::unique_ptr<audio::AbstractStreamSource>
+        {
+            if( boost::filesystem::is_regular_file("data/tr1/audio/CDAUDIO.WAD") )
+                return std::make_unique<audio::WadStreamSource>("data/tr1/audio/CDAUDIO.WAD", trackId);
+
+            return std::make_unique<audio::SndfileStreamSource>((boost::format("data/tr1/audio/%03d.ogg") % trackId).str());
+        }, DefaultBufferSize, DefaultBufferCount);
 
     m_audioDev.registerStream(m_cdStream);
 }
@@ -1,12 +1,17 @@
 #pragma once
 
 #include "audio/device.h"
+#include "audio/samplecache.h"
 #include "audio/streamsource.h"
+#include "engine/ai/routecache.h"
+#include "engine/ai/scheduler.h"
 #include "engine/cameracontroller.h"
+#include "engine/floordata/sectorcache.h"
 #include "engine/inputhandler.h"
 #include "engine/items/itemnode.h"
 #include "game.h"
 #include "loader/animation.h"
+#include "loader/assetexporter.h"
 #include "loader/datatypes.h"
 #include "loader/item.h"
 #include "loader/mesh.h"
@@ -65,8 +70,18 @@ namespace level
         std::vector<uint16_t> m_overlaps;
         loader::Zones m_baseZones;
         loader::Zones m_alternateZones;
+        //! Built by setUpRendering(), before the items are created
+        std::unique_ptr<render::ItemLighting> m_itemLighting;
+        //! Built by setUpRendering(), after all level data is loaded
+        std::unique_ptr<engine::floordata::SectorCache> m_sectorCache;
+        //! Built by setUpRendering(), after all level data is loaded
+        std::unique_ptr<engine::ai::RouteCache> m_routeCache;
+        //! Built by setUpRendering(), after the items are created
+        std::unique_ptr<engine::ai::Scheduler> m_aiScheduler;
         std::vector<loader::Item> m_items;
         std::map<uint16_t, std::shared_ptr<engine::items::ItemNode>> m_itemNodes;
+        //! Items of m_itemNodes that need to be updated, ordered by item id; maintained by the items
+        std::vector<engine::items::ItemNode*> m_activeItems;
         std::set<std::shared_ptr<engine::items::ItemNode>> m_dynamicItems;
         std::set<std::shared_ptr<gameplay::Node>> m_scheduledDeletions;
         std::unique_ptr<loader::LightMap> m_lightmap;
@@ -83,6 +98,10 @@ namespace level
         std::vector<int32_t> m_boneTrees;
 
         std::string m_sfxPath = "MAIN.SFX";
+        //! MD5 of the level file, set by LevelCache::load()
+        std::string m_sourceHash;
+        //! Writes the exported assets in the background; created by setUpRendering()
+        std::unique_ptr<loader::AssetExporter> m_assetExporter;
 
         /*
          * 0 Normal
@@ -109,13 +128,16 @@ namespace level
         boost::optional<size_t> findAnimatedModelIndexForType(uint32_t type) const;
         boost::optional<size_t> findSpriteSequenceForType(uint32_t type) const;
 
-        std::vector<std::shared_ptr<gameplay::gl::Texture>> createTextures(loader::trx::Glidos* glidos, const boost::filesystem::path& lvlName);
-        std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>> createMaterials(const std::vector<std::shared_ptr<gameplay::gl::Texture>>& textures, const std::shared_ptr<gameplay::ShaderProgram>& shader);
+        std::shared_ptr<gameplay::gl::Texture> createTextures(loader::trx::Glidos* glidos, const boost::filesystem::path& lvlName);
+        std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>> createMaterials(const std::shared_ptr<gameplay::gl::Texture>& textures, const std::shared_ptr<gameplay::ShaderProgram>& shader);
+        //! Mask for TextureKey::tileAndFlag, yielding the texture page, i.e. the texture array layer
+        uint16_t getTextureIndexMask() const;
         engine::LaraNode* createItems();
         void setUpRendering(gameplay::Game* game,
                             const boost::filesystem::path& assetPath,
                             const boost::filesystem::path& lvlName,
-                            const std::unique_ptr<loader::trx::Glidos>& glidos);
+                            const std::unique_ptr<loader::trx::Glidos>& glidos,
+                            bool exportAssets);
 
 
         template<typename T>
@@ -168,23 +190,17 @@ namespace level
 
         std::tuple<int8_t, int8_t> getFloorSlantInfo(gsl::not_null<const loader::Sector*> sector, const core::TRCoordinates& position) const
         {
-            while( sector->roomBelow != 0xff )
-            {
-                auto room = &m_rooms[sector->roomBelow];
-                sector = room->getSectorByAbsolutePosition(position);
-            }
+            sector = m_sectorCache->get(sector).floorSector;
+            const auto& decoded = m_sectorCache->get(sector);
 
             static const auto zero = std::make_tuple(0, 0);
 
             if( position.Y + loader::QuarterSectorSize * 2 < sector->floorHeight * loader::QuarterSectorSize )
                 return zero;
-            if( sector->floorDataIndex == 0 )
-                return zero;
-            if( engine::floordata::FloorDataChunk{m_floorData[sector->floorDataIndex]}.type != engine::floordata::FloorDataChunkType::FloorSlant )
+            if( !decoded.hasFloorSlant )
                 return zero;
 
-            auto fd = m_floorData[sector->floorDataIndex + 1];
-            return std::make_tuple(gsl::narrow_cast<int8_t>(fd & 0xff), gsl::narrow_cast<int8_t>(fd >> 8));
+            return std::make_tuple(decoded.floorSlantX, decoded.floorSlantZ);
         }
 
 
@@ -198,37 +214,36 @@ namespace level
         std::unique_ptr<engine::InputHandler> m_inputHandler;
 
         audio::Device m_audioDev;
-        std::map<size_t, std::weak_ptr<audio::SourceHandle>> m_samples;
+        audio::SampleCache m_sampleCache;
+        std::map<size_t, std::weak_ptr<audio::Voice>> m_samples;
 
 
-        std::shared_ptr<audio::SourceHandle> playSample(size_t sample, float pitch, float volume, const boost::optional<glm::vec3>& pos)
+        std::shared_ptr<audio::Voice> playSample(size_t sample, float pitch, float volume, const boost::optional<glm::vec3>& pos, const loader::SoundDetails& details, bool looping)
         {
             Expects(sample < m_sampleIndices.size());
             pitch = util::clamp(pitch, 0.5f, 2.0f);
             volume = util::clamp(volume, 0.0f, 1.0f);
 
-            std::shared_ptr<audio::BufferHandle> buf = std::make_shared<audio::BufferHandle>();
             const auto offset = m_sampleIndices[sample];
             BOOST_ASSERT(offset < m_samplesData.size());
-            buf->fillFromWav(&m_samplesData[offset]);
 
-            std::shared_ptr<audio::SourceHandle> src = std::make_shared<audio::SourceHandle>();
-            src->setBuffer(buf);
-            src->setPitch(pitch);
-            src->setGain(volume);
-            if( pos )
-                src->setPosition(*pos);
+            auto voice = std::make_shared<audio::Voice>(m_sampleCache.get(sample, &m_samplesData[offset]),
+                                                        details.getPriority(level::Engine::TR1),
+                                                        details.getMaxDistance());
+            voice->setPitch(pitch);
+            voice->setGain(volume);
+            voice->setPosition(pos);
+            voice->setLooping(looping);
+            voice->play();
 
-            src->play();
+            m_audioDev.registerVoice(voice);
+            m_samples[sample] = voice;
 
-            m_audioDev.registerSource(src);
-            m_samples[sample] = src;
-
-            return src;
+            return voice;
         }
 
 
-        std::shared_ptr<audio::SourceHandle> playSound(int id, const boost::optional<glm::vec3>& position)
+        std::shared_ptr<audio::Voice> playSound(int id, const boost::optional<glm::vec3>& position)
         {
             Expects(id >= 0 && static_cast<size_t>(id) < m_soundmap.size());
             auto snd = m_soundmap[id];
@@ -258,11 +273,10 @@ namespace level
             if( volume <= 0 )
                 return nullptr;
 
-            std::shared_ptr<audio::SourceHandle> handle;
+            std::shared_ptr<audio::Voice> handle;
             if( details.getPlaybackType(level::Engine::TR1) == loader::PlaybackType::Looping )
             {
-                handle = playSample(sample, pitch, volume, position);
-                handle->setLooping(true);
+                handle = playSample(sample, pitch, volume, position, details, true);
             }
             else if( details.getPlaybackType(level::Engine::TR1) == loader::PlaybackType::Restart )
             {
@@ -273,7 +287,7 @@ namespace level
                 }
                 else
                 {
-                    handle = playSample(sample, pitch, volume, position);
+                    handle = playSample(sample, pitch, volume, position, details, false);
                 }
             }
             else if( details.getPlaybackType(level::Engine::TR1) == loader::PlaybackType::Wait )
@@ -281,19 +295,19 @@ namespace level
                 handle = findSample(sample);
                 if( handle == nullptr )
                 {
-                    handle = playSample(sample, pitch, volume, position);
+                    handle = playSample(sample, pitch, volume, position, details, false);
                 }
             }
             else
             {
-                handle = playSample(sample, pitch, volume, position);
+                handle = playSample(sample, pitch, volume, position, details, false);
             }
 
             return handle;
         }
 
 
-        std::shared_ptr<audio::SourceHandle> findSample(size_t sample) const
+        std::shared_ptr<audio::Voice> findSample(size_t sample) const
         {
             auto it = m_samples.find(sample);
             if( it == m_samples.end() )
@@ -356,6 +370,20 @@ namespace level
         }
 
 
+        /**
+         * @brief Returns a single model containing all bone meshes, to be drawn using a bone palette.
+         * @param[in] boneDrawables The bone meshes; each must be one of the models returned by getModel().
+         * @return @c nullptr if the meshes can't be merged, e.g. because one of them has been overridden.
+         *
+         * Models are cached per mesh combination, so items sharing a skeleton share the skinned model.
+         */
+        std::shared_ptr<gameplay::Model> getSkinnedModel(const std::vector<std::shared_ptr<gameplay::Drawable>>& boneDrawables) const;
+
+
+        //! Updates the active items of the level data, and the items created at runtime; Lara is not updated.
+        void updateItems();
+
+
         void scheduleDeletion(const std::shared_ptr<gameplay::Node>& item)
         {
             m_scheduledDeletions.insert(item);
@@ -363,14 +391,12 @@ namespace level
 
         void applyScheduledDeletions()
         {
-            if(m_scheduledDeletions.empty())
-                return;
-
-            auto old = std::move(m_dynamicItems);
-            BOOST_ASSERT(m_dynamicItems.empty());
-            std::set_difference(old.begin(), old.end(),
-                                m_scheduledDeletions.begin(), m_scheduledDeletions.end(),
-                                std::inserter(m_dynamicItems, m_dynamicItems.begin()));
+            for( const auto& node : m_scheduledDeletions )
+            {
+                if( const auto item = std::dynamic_pointer_cast<engine::items::ItemNode>(node) )
+                    m_dynamicItems.erase(item);
+            }
+
             m_scheduledDeletions.clear();
         }
 
@@ -414,5 +440,10 @@ namespace level
         std::array<engine::floordata::ActivationState, 64> m_cdTrackActivationStates;
         int m_cdTrack50time = 0;
         std::vector<std::shared_ptr<gameplay::Model>> m_models;
+        //! Indices into m_models which were replaced by override models, and thus can't be skinned
+        std::set<size_t> m_overriddenModels;
+        std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>> m_skinnedMaterials;
+        std::shared_ptr<gameplay::Material> m_skinnedColorMaterial;
+        mutable std::map<std::vector<size_t>, std::shared_ptr<gameplay::Model>> m_skinnedModels;
     };
 }
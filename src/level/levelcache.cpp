@@ -0,0 +1,541 @@
+#include "levelcache.h"
+
+#include "level.h"
+
+#include "util/md5.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+using namespace level;
+
+
+namespace
+{
+    constexpr const char CacheMagic[4] = {'E', 'E', 'L', 'C'};
+    //! Increment whenever the layout of the cache or of one of the cached structures changes.
+    constexpr uint32_t CacheVersion = 3;
+    constexpr size_t SectionAlignment = 8;
+
+
+    class CacheWriter
+    {
+    public:
+        explicit CacheWriter(std::ostream& stream)
+            : m_stream{stream}
+        {
+        }
+
+
+        template<typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be written directly");
+            writeRaw(&value, sizeof(T));
+        }
+
+
+        template<typename T>
+        void write(const std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be written directly");
+            write<uint64_t>(values.size());
+            writeRaw(values.data(), values.size() * sizeof(T));
+        }
+
+
+        void write(const std::string& value)
+        {
+            write<uint64_t>(value.size());
+            writeRaw(value.data(), value.size());
+        }
+
+
+        template<typename T>
+        void write(const std::unique_ptr<T>& value)
+        {
+            write<uint8_t>(value != nullptr);
+            if( value != nullptr )
+                write(*value);
+        }
+
+
+    private:
+        std::ostream& m_stream;
+        size_t m_position = 0;
+
+
+        void writeRaw(const void* data, size_t size)
+        {
+            m_stream.write(static_cast<const char*>(data), size);
+            m_position += size;
+
+            static const char padding[SectionAlignment] = {0};
+            const auto padSize = (SectionAlignment - m_position % SectionAlignment) % SectionAlignment;
+            m_stream.write(padding, padSize);
+            m_position += padSize;
+        }
+    };
+
+
+    class CacheReader
+    {
+    public:
+        CacheReader(const char* data, size_t size)
+            : m_data{data}
+            , m_end{data + size}
+        {
+        }
+
+
+        template<typename T>
+        T read()
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be read directly");
+            T result;
+            readRaw(&result, sizeof(T));
+            return result;
+        }
+
+
+        template<typename T>
+        void read(T& value)
+        {
+            value = read<T>();
+        }
+
+
+        template<typename T, size_t N>
+        void read(T (&values)[N])
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be read directly");
+            readRaw(values, sizeof(values));
+        }
+
+
+        template<typename T>
+        void read(std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable data can be read directly");
+            values.resize(readCount(sizeof(T)));
+            readRaw(values.data(), values.size() * sizeof(T));
+        }
+
+
+        void read(std::string& value)
+        {
+            value.resize(readCount(1));
+            readRaw(&value[0], value.size());
+        }
+
+
+        template<typename T>
+        void read(std::unique_ptr<T>& value)
+        {
+            if( read<uint8_t>() == 0 )
+            {
+                value.reset();
+                return;
+            }
+
+            value = std::make_unique<T>();
+            read(*value);
+        }
+
+
+        size_t readCount(size_t elementSize)
+        {
+            const auto count = read<uint64_t>();
+            if( count > static_cast<uint64_t>(m_end - m_data) / elementSize )
+                BOOST_THROW_EXCEPTION(std::runtime_error("Level cache is truncated"));
+            return static_cast<size_t>(count);
+        }
+
+
+    private:
+        const char* m_data;
+        const char* const m_end;
+
+
+        void readRaw(void* dest, size_t size)
+        {
+            const auto paddedSize = (size + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+            if( static_cast<size_t>(m_end - m_data) < paddedSize )
+                BOOST_THROW_EXCEPTION(std::runtime_error("Level cache is truncated"));
+
+            std::memcpy(dest, m_data, size);
+            m_data += paddedSize;
+        }
+    };
+
+
+    // Structures which are not trivially copyable are (de-)serialized member-wise.
+
+    void serialize(CacheWriter& writer, const loader::Room& room)
+    {
+        writer.write(room.position);
+        writer.write(room.lowestHeight);
+        writer.write(room.greatestHeight);
+        writer.write(room.layers);
+        writer.write(room.vertices);
+        writer.write(room.rectangles);
+        writer.write(room.triangles);
+        writer.write(room.sprites);
+        writer.write(room.portals);
+        writer.write(room.sectorCountZ);
+        writer.write(room.sectorCountX);
+        writer.write(room.sectors);
+        writer.write(room.ambientDarkness);
+        writer.write(room.intensity2);
+        writer.write(room.lightMode);
+        writer.write(room.lights);
+        writer.write(room.staticMeshes);
+        writer.write(room.alternateRoom);
+        writer.write(room.alternateGroup);
+        writer.write(room.flags);
+        writer.write(room.waterScheme);
+        writer.write(room.reverbInfo);
+        writer.write(room.lightColor);
+        writer.write(room.room_x);
+        writer.write(room.room_z);
+        writer.write(room.room_y_bottom);
+        writer.write(room.room_y_top);
+        writer.write(room.unknown_r1);
+        writer.write(room.unknown_r2);
+        writer.write(room.unknown_r3);
+        writer.write(room.unknown_r4a);
+        writer.write(room.unknown_r4b);
+        writer.write(room.unknown_r5);
+        writer.write(room.unknown_r6);
+    }
+
+
+    void deserialize(CacheReader& reader, loader::Room& room)
+    {
+        reader.read(room.position);
+        reader.read(room.lowestHeight);
+        reader.read(room.greatestHeight);
+        reader.read(room.layers);
+        reader.read(room.vertices);
+        reader.read(room.rectangles);
+        reader.read(room.triangles);
+        reader.read(room.sprites);
+        reader.read(room.portals);
+        reader.read(room.sectorCountZ);
+        reader.read(room.sectorCountX);
+        reader.read(room.sectors);
+        reader.read(room.ambientDarkness);
+        reader.read(room.intensity2);
+        reader.read(room.lightMode);
+        reader.read(room.lights);
+        reader.read(room.staticMeshes);
+        reader.read(room.alternateRoom);
+        reader.read(room.alternateGroup);
+        reader.read(room.flags);
+        reader.read(room.waterScheme);
+        reader.read(room.reverbInfo);
+        reader.read(room.lightColor);
+        reader.read(room.room_x);
+        reader.read(room.room_z);
+        reader.read(room.room_y_bottom);
+        reader.read(room.room_y_top);
+        reader.read(room.unknown_r1);
+        reader.read(room.unknown_r2);
+        reader.read(room.unknown_r3);
+        reader.read(room.unknown_r4a);
+        reader.read(room.unknown_r4b);
+        reader.read(room.unknown_r5);
+        reader.read(room.unknown_r6);
+    }
+
+
+    void serialize(CacheWriter& writer, const loader::Mesh& mesh)
+    {
+        writer.write(mesh.center);
+        writer.write(mesh.collision_size);
+        writer.write(mesh.vertices);
+        writer.write(mesh.normals);
+        writer.write(mesh.vertexDarknesses);
+        writer.write(mesh.textured_rectangles);
+        writer.write(mesh.textured_triangles);
+        writer.write(mesh.colored_rectangles);
+        writer.write(mesh.colored_triangles);
+    }
+
+
+    void deserialize(CacheReader& reader, loader::Mesh& mesh)
+    {
+        reader.read(mesh.center);
+        reader.read(mesh.collision_size);
+        reader.read(mesh.vertices);
+        reader.read(mesh.normals);
+        reader.read(mesh.vertexDarknesses);
+        reader.read(mesh.textured_rectangles);
+        reader.read(mesh.textured_triangles);
+        reader.read(mesh.colored_rectangles);
+        reader.read(mesh.colored_triangles);
+    }
+
+
+    void serialize(CacheWriter& writer, const loader::StaticMesh& mesh)
+    {
+        writer.write(mesh.id);
+        writer.write(mesh.mesh);
+        writer.write(mesh.visibility_box.min);
+        writer.write(mesh.visibility_box.max);
+        writer.write(mesh.collision_box.min);
+        writer.write(mesh.collision_box.max);
+        writer.write(mesh.flags);
+    }
+
+
+    void deserialize(CacheReader& reader, loader::StaticMesh& mesh)
+    {
+        reader.read(mesh.id);
+        reader.read(mesh.mesh);
+        reader.read(mesh.visibility_box.min);
+        reader.read(mesh.visibility_box.max);
+        reader.read(mesh.collision_box.min);
+        reader.read(mesh.collision_box.max);
+        reader.read(mesh.flags);
+    }
+
+
+    void serialize(CacheWriter& writer, const loader::DWordTexture& texture)
+    {
+        writer.write(texture.pixels);
+        writer.write(texture.md5);
+    }
+
+
+    void deserialize(CacheReader& reader, loader::DWordTexture& texture)
+    {
+        reader.read(texture.pixels);
+        reader.read(texture.md5);
+    }
+
+
+    void serialize(CacheWriter& writer, const loader::Zones& zones)
+    {
+        writer.write(zones.groundZone1);
+        writer.write(zones.groundZone2);
+        writer.write(zones.flyZone);
+    }
+
+
+    void deserialize(CacheReader& reader, loader::Zones& zones)
+    {
+        reader.read(zones.groundZone1);
+        reader.read(zones.groundZone2);
+        reader.read(zones.flyZone);
+    }
+
+
+    template<typename T>
+    void writeElements(CacheWriter& writer, const std::vector<T>& values)
+    {
+        writer.write<uint64_t>(values.size());
+        for( const auto& value : values )
+            serialize(writer, value);
+    }
+
+
+    template<typename T>
+    void readElements(CacheReader& reader, std::vector<T>& values)
+    {
+        values.clear();
+        values.resize(reader.readCount(1));
+        for( auto& value : values )
+            deserialize(reader, value);
+    }
+
+
+    std::string hashFile(const boost::filesystem::path& path)
+    {
+        boost::iostreams::mapped_file_source file{path.string()};
+        return util::md5(file.data(), file.size());
+    }
+}
+
+
+void LevelCache::load(Level& level, const boost::filesystem::path& sourcePath, const boost::filesystem::path& cachePath)
+{
+    const auto startTime = std::chrono::high_resolution_clock::now();
+    const auto key = hashFile(sourcePath);
+    level.m_sourceHash = key;
+
+    bool cached = false;
+    try
+    {
+        cached = read(level, key, cachePath);
+    }
+    catch( std::exception& ex )
+    {
+        BOOST_LOG_TRIVIAL(warning) << "Failed to read level cache " << cachePath << ": " << ex.what();
+    }
+
+    if( !cached )
+    {
+        level.loadFileData();
+
+        try
+        {
+            write(level, key, cachePath);
+        }
+        catch( std::exception& ex )
+        {
+            BOOST_LOG_TRIVIAL(warning) << "Failed to write level cache " << cachePath << ": " << ex.what();
+        }
+    }
+
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - startTime);
+    BOOST_LOG_TRIVIAL(info) << "Loaded " << sourcePath << (cached ? " from cache" : "") << " in " << duration.count() << "ms";
+}
+
+
+bool LevelCache::read(Level& level, const std::string& key, const boost::filesystem::path& cachePath)
+{
+    if( !boost::filesystem::is_regular_file(cachePath) )
+        return false;
+
+    boost::iostreams::mapped_file_source file{cachePath.string()};
+    CacheReader reader{file.data(), file.size()};
+
+    const auto magic = reader.read<std::array<char, 4>>();
+    if( std::memcmp(magic.data(), CacheMagic, sizeof(CacheMagic)) != 0 || reader.read<uint32_t>() != CacheVersion )
+    {
+        BOOST_LOG_TRIVIAL(info) << "Level cache " << cachePath << " has an incompatible format";
+        return false;
+    }
+
+    std::string cachedKey;
+    reader.read(cachedKey);
+    if( cachedKey != key || reader.read<Game>() != level.m_gameVersion )
+    {
+        BOOST_LOG_TRIVIAL(info) << "Level cache " << cachePath << " is outdated";
+        return false;
+    }
+
+    readElements(reader, level.m_textures);
+    reader.read(level.m_palette);
+    readElements(reader, level.m_rooms);
+    reader.read(level.m_floorData);
+    readElements(reader, level.m_meshes);
+    reader.read(level.m_meshIndices);
+    reader.read(level.m_animations);
+    reader.read(level.m_transitions);
+    reader.read(level.m_transitionCases);
+    reader.read(level.m_animCommands);
+    level.m_animatedModels.resize(reader.readCount(1));
+    for( auto& model : level.m_animatedModels )
+        reader.read(model);
+    readElements(reader, level.m_staticMeshes);
+    reader.read(level.m_textureProxies);
+    reader.read(level.m_animatedTextures);
+    level.m_animatedTexturesUvCount = gsl::narrow<size_t>(reader.read<uint64_t>());
+    reader.read(level.m_spriteTextures);
+    reader.read(level.m_spriteSequences);
+    reader.read(level.m_cameras);
+    reader.read(level.m_flybyCameras);
+    reader.read(level.m_soundSources);
+    reader.read(level.m_boxes);
+    reader.read(level.m_overlaps);
+    deserialize(reader, level.m_baseZones);
+    deserialize(reader, level.m_alternateZones);
+    reader.read(level.m_items);
+    reader.read(level.m_lightmap);
+    reader.read(level.m_aiObjects);
+    reader.read(level.m_cinematicFrames);
+    reader.read(level.m_demoData);
+    reader.read(level.m_soundmap);
+    reader.read(level.m_soundDetails);
+    level.m_samplesCount = gsl::narrow<size_t>(reader.read<uint64_t>());
+    reader.read(level.m_samplesData);
+    reader.read(level.m_sampleIndices);
+    reader.read(level.m_poseData);
+    reader.read(level.m_boneTrees);
+    reader.read(level.m_laraType);
+    reader.read(level.m_weatherType);
+
+    return true;
+}
+
+
+void LevelCache::write(const Level& level, const std::string& key, const boost::filesystem::path& cachePath)
+{
+    if( cachePath.has_parent_path() )
+        boost::filesystem::create_directories(cachePath.parent_path());
+
+    // write to a temporary file first, so that an interrupted write never leaves a broken cache behind
+    auto tmpPath = cachePath;
+    tmpPath += ".tmp";
+
+    {
+        std::ofstream file{tmpPath.string(), std::ios::out | std::ios::binary | std::ios::trunc};
+        if( !file.is_open() )
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to create level cache file"));
+
+        CacheWriter writer{file};
+
+        std::array<char, 4> magic;
+        std::copy(std::begin(CacheMagic), std::end(CacheMagic), magic.begin());
+        writer.write(magic);
+        writer.write(CacheVersion);
+        writer.write(key);
+        writer.write(level.m_gameVersion);
+
+        writeElements(writer, level.m_textures);
+        writer.write(level.m_palette);
+        writeElements(writer, level.m_rooms);
+        writer.write(level.m_floorData);
+        writeElements(writer, level.m_meshes);
+        writer.write(level.m_meshIndices);
+        writer.write(level.m_animations);
+        writer.write(level.m_transitions);
+        writer.write(level.m_transitionCases);
+        writer.write(level.m_animCommands);
+        writer.write<uint64_t>(level.m_animatedModels.size());
+        for( const auto& model : level.m_animatedModels )
+            writer.write(model);
+        writeElements(writer, level.m_staticMeshes);
+        writer.write(level.m_textureProxies);
+        writer.write(level.m_animatedTextures);
+        writer.write<uint64_t>(level.m_animatedTexturesUvCount);
+        writer.write(level.m_spriteTextures);
+        writer.write(level.m_spriteSequences);
+        writer.write(level.m_cameras);
+        writer.write(level.m_flybyCameras);
+        writer.write(level.m_soundSources);
+        writer.write(level.m_boxes);
+        writer.write(level.m_overlaps);
+        serialize(writer, level.m_baseZones);
+        serialize(writer, level.m_alternateZones);
+        writer.write(level.m_items);
+        writer.write(level.m_lightmap);
+        writer.write(level.m_aiObjects);
+        writer.write(level.m_cinematicFrames);
+        writer.write(level.m_demoData);
+        writer.write(level.m_soundmap);
+        writer.write(level.m_soundDetails);
+        writer.write<uint64_t>(level.m_samplesCount);
+        writer.write(level.m_samplesData);
+        writer.write(level.m_sampleIndices);
+        writer.write(level.m_poseData);
+        writer.write(level.m_boneTrees);
+        writer.write(level.m_laraType);
+        writer.write(level.m_weatherType);
+
+        if( !file )
+            BOOST_THROW_EXCEPTION(std::runtime_error("Failed to write level cache file"));
+    }
+
+    boost::filesystem::rename(tmpPath, cachePath);
+
+    BOOST_LOG_TRIVIAL(info) << "Wrote level cache " << cachePath;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <boost/filesystem/path.hpp>
+
+#include <string>
+
+namespace level
+{
+    class Level;
+
+    /**
+     * @brief Engine-native snapshot of a parsed level.
+     *
+     * Holds the flattened level arrays as they are after Level::loadFileData(), so that warm starts
+     * don't need to parse (and, for TR4/TR5, decompress) the original level file again.  The cache
+     * is keyed by the MD5 of the original level file; a different key, game version or cache format
+     * version makes it stale, and it is rebuilt.
+     *
+     * All sections are 8-byte aligned, so a memory-mapped cache file can be used in place; loading
+     * is one bulk copy per array.
+     */
+    class LevelCache
+    {
+    public:
+        /**
+         * @brief Fills @a level from the cache, or parses the level file and (re-)creates the cache.
+         * @param[in,out] level The level to fill.
+         * @param[in] sourcePath Path of the original level file; its contents are the cache key.
+         * @param[in] cachePath Path of the cache file.
+         */
+        static void load(Level& level, const boost::filesystem::path& sourcePath, const boost::filesystem::path& cachePath);
+
+    private:
+        static bool read(Level& level, const std::string& key, const boost::filesystem::path& cachePath);
+        static void write(const Level& level, const std::string& key, const boost::filesystem::path& cachePath);
+    };
+}
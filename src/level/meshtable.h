@@ -0,0 +1,43 @@
+#pragma once
+
+#include <boost/assert.hpp>
+
+#include <gsl/gsl>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace level
+{
+    /**
+     * @brief Replaces mesh pointers by the indices of the meshes they point to.
+     *
+     * Mesh pointers are byte offsets into the mesh data, and many of them usually share the same mesh.
+     * Every distinct mesh is read exactly once, in file order, and the pointers are then mapped to mesh
+     * indices by binary search.
+     *
+     * @param[in,out] meshPointers The mesh data offsets, replaced by mesh indices.
+     * @param[in] readMesh Called with the offset of every distinct mesh, in ascending order.
+     * @returns The number of distinct meshes.
+     */
+    template<typename F>
+    size_t buildMeshTable(std::vector<uint32_t>& meshPointers, F&& readMesh)
+    {
+        std::vector<uint32_t> offsets{meshPointers};
+        std::sort(offsets.begin(), offsets.end());
+        offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+        for( const auto offset : offsets )
+            readMesh(offset);
+
+        for( auto& meshPointer : meshPointers )
+        {
+            const auto it = std::lower_bound(offsets.begin(), offsets.end(), meshPointer);
+            BOOST_ASSERT( it != offsets.end() && *it == meshPointer );
+            meshPointer = gsl::narrow<uint32_t>(std::distance(offsets.begin(), it));
+        }
+
+        return offsets.size();
+    }
+}
@@ -127,12 +127,11 @@ void TR3Level::loadFileData()
     }
     else
     {
-        m_samplesData.resize(static_cast<size_t>(newsrc.size()));
+        newsrc.readVector(m_samplesData, static_cast<size_t>(newsrc.size()));
         m_samplesCount = 0;
-        for(size_t i = 0; i < m_samplesData.size(); i++)
+        for(size_t i = 4; i < m_samplesData.size(); i++)
         {
-            m_samplesData[i] = newsrc.readU8();
-            if(i >= 4 && *reinterpret_cast<uint32_t*>(m_samplesData.data() + i - 4) == 0x46464952)   /// RIFF
+            if(*reinterpret_cast<uint32_t*>(m_samplesData.data() + i - 4) == 0x46464952)   /// RIFF
             {
                 m_samplesCount++;
             }
@@ -0,0 +1,159 @@
+#include "assetexporter.h"
+
+#include "datatypes.h"
+
+#include "util/md5.h"
+
+#include <boost/log/trivial.hpp>
+
+#include <fstream>
+
+
+namespace loader
+{
+AssetExporter::AssetExporter(const boost::filesystem::path& basePath)
+    : m_converter{basePath}
+    , m_manifestPath{basePath / "_export.yaml"}
+    , m_pool{std::make_unique<util::ThreadPool>()}
+{
+    if( !is_regular_file(m_manifestPath) )
+        return;
+
+    try
+    {
+        const auto manifest = YAML::LoadFile(m_manifestPath.string());
+        for( const auto& entry : manifest )
+            m_manifest[entry.first.as<std::string>()] = entry.second.as<std::string>();
+    }
+    catch( std::exception& ex )
+    {
+        BOOST_LOG_TRIVIAL(warning) << "Failed to read export manifest " << m_manifestPath << ": " << ex.what();
+        m_manifest.clear();
+    }
+}
+
+
+AssetExporter::~AssetExporter()
+{
+    m_pool.reset();
+
+    BOOST_LOG_TRIVIAL(info) << "Asset export: " << m_writtenCount << " files written, " << m_upToDateCount << " up to date";
+
+    YAML::Node manifest;
+    for( const auto& entry : m_manifest )
+        manifest[entry.first] = entry.second;
+
+    std::ofstream file{m_manifestPath.string(), std::ios::trunc};
+    file << manifest;
+}
+
+
+bool AssetExporter::isUpToDate(const std::string& filename, const std::string& sourceHash) const
+{
+    {
+        std::lock_guard<std::mutex> lock{m_manifestMutex};
+        auto it = m_manifest.find(filename);
+        if( it == m_manifest.end() || it->second != makeManifestHash(sourceHash) )
+            return false;
+    }
+
+    if( !m_converter.exists(filename) )
+        return false;
+
+    ++m_upToDateCount;
+    return true;
+}
+
+
+void AssetExporter::write(const DWordTexture& texture, size_t id)
+{
+    const auto filename = Converter::makeTextureName(id) + ".png";
+    const auto sourceHash = util::md5(&texture.pixels[0][0].r, sizeof(texture.pixels));
+    if( isUpToDate(filename, sourceHash) )
+        return;
+
+    enqueue(filename, sourceHash, [this, image = texture.toImage(), id]()
+    {
+        m_converter.write(image, id);
+    });
+}
+
+
+void AssetExporter::write(const std::shared_ptr<gameplay::Model>& model,
+                          const std::string& filename,
+                          const std::string& sourceHash,
+                          const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
+                          const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2,
+                          const glm::vec3& ambientColor)
+{
+    if( isUpToDate(filename, sourceHash) )
+        return;
+
+    BOOST_LOG_TRIVIAL(info) << "Saving model " << filename;
+    enqueue(filename, sourceHash, [this, scene = m_converter.createScene(model, mtlMap1, mtlMap2, ambientColor), filename]()
+    {
+        m_converter.write(*scene, filename);
+    });
+}
+
+
+void AssetExporter::write(const std::vector<Room>& rooms,
+                          const std::vector<Box>& boxes,
+                          const std::string& filename,
+                          const std::string& sourceHash,
+                          const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
+                          const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2)
+{
+    if( isUpToDate(filename, sourceHash) )
+        return;
+
+    BOOST_LOG_TRIVIAL(info) << "Saving level " << filename;
+    enqueue(filename, sourceHash, [this, scene = m_converter.createScene(rooms, boxes, mtlMap1, mtlMap2), filename]()
+    {
+        m_converter.write(*scene, filename);
+    });
+}
+
+
+void AssetExporter::write(const std::string& filename, const std::string& sourceHash, const YAML::Node& tree)
+{
+    if( isUpToDate(filename, sourceHash) )
+        return;
+
+    BOOST_LOG_TRIVIAL(info) << "Saving " << filename;
+    // YAML nodes share their data, so the tree must not be used by the caller anymore
+    enqueue(filename, sourceHash, [this, tree, filename]()
+    {
+        m_converter.write(filename, tree);
+    });
+}
+
+
+template<typename F>
+void AssetExporter::enqueue(const std::string& filename, const std::string& sourceHash, F&& job)
+{
+    m_pool->enqueue([this, job = std::forward<F>(job), filename, sourceHash]()
+    {
+        try
+        {
+            job();
+        }
+        catch( std::exception& ex )
+        {
+            BOOST_LOG_TRIVIAL(warning) << "Failed to export " << filename << ": " << ex.what();
+            return;
+        }
+
+        ++m_writtenCount;
+
+        std::lock_guard<std::mutex> lock{m_manifestMutex};
+        m_manifest[filename] = makeManifestHash(sourceHash);
+    });
+}
+
+
+std::string AssetExporter::makeManifestHash(const std::string& sourceHash)
+{
+    return std::to_string(Version) + ":" + sourceHash;
+}
+}
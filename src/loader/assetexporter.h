@@ -0,0 +1,78 @@
+#pragma once
+
+#include "converter.h"
+
+#include "util/threadpool.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+
+namespace loader
+{
+/**
+ * @brief Exports the level assets for editing, skipping outputs that are up to date.
+ *
+ * Each written file is recorded in a manifest in the asset directory, together with the hash of the
+ * data it was generated from; a file is only written again if it is missing or its source hash
+ * changed.  Outputs that are no longer recorded, e.g. those exported before the manifest existed,
+ * are written once.
+ *
+ * The data is collected on the calling thread, as models are read back from the GL buffers, while
+ * encoding and writing the files happens on worker threads.  The destructor waits for them and
+ * saves the manifest.
+ */
+class AssetExporter final : public boost::noncopyable
+{
+public:
+    //! Changing this forces all outputs to be re-generated, e.g. after changing the export code
+    static constexpr int Version = 2;
+
+    explicit AssetExporter(const boost::filesystem::path& basePath);
+
+    ~AssetExporter();
+
+    //! Allows skipping the collection of the data for an output that doesn't need to be written
+    bool isUpToDate(const std::string& filename, const std::string& sourceHash) const;
+
+    void write(const DWordTexture& texture, size_t id);
+
+    void write(const std::shared_ptr<gameplay::Model>& model,
+               const std::string& filename,
+               const std::string& sourceHash,
+               const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
+               const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2,
+               const glm::vec3& ambientColor);
+
+    void write(const std::vector<Room>& rooms,
+               const std::vector<Box>& boxes,
+               const std::string& filename,
+               const std::string& sourceHash,
+               const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
+               const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2);
+
+    void write(const std::string& filename, const std::string& sourceHash, const YAML::Node& tree);
+
+private:
+    const Converter m_converter;
+    const boost::filesystem::path m_manifestPath;
+
+    //! Maps the file names to the hashes of their sources
+    std::map<std::string, std::string> m_manifest;
+    mutable std::mutex m_manifestMutex;
+
+    std::atomic<size_t> m_writtenCount{0};
+    mutable std::atomic<size_t> m_upToDateCount{0};
+
+    //! Destroyed first, so that all jobs are done before the manifest is saved
+    std::unique_ptr<util::ThreadPool> m_pool;
+
+
+    //! Runs @a job on a worker, and records the output in the manifest when it succeeds
+    template<typename F>
+    void enqueue(const std::string& filename, const std::string& sourceHash, F&& job);
+
+    static std::string makeManifestHash(const std::string& sourceHash);
+};
+}
@@ -137,6 +137,22 @@ namespace loader
             return (flags & 0x10) != 0;
         }
 
+        //! @brief Distance in world units (the range is given in sectors) beyond which the sound is inaudible.
+        float getMaxDistance() const
+        {
+            return sound_range * 1024.0f;
+        }
+
+        /**
+         * @brief Priority of this sound when competing for hardware voices.
+         *
+         * Looped ambience can be resumed later at the right position, so it yields to one-shot effects.
+         */
+        float getPriority(level::Engine engine) const
+        {
+            return getPlaybackType(engine) == PlaybackType::Looping ? 0.5f : 1.0f;
+        }
+
         bool useRandomPitch() const
         {
             return (flags & 0x20) != 0;
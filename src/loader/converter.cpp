@@ -1,7 +1,8 @@
 #include "converter.h"
 
 #include "datatypes.h"
-#include "engine/items/itemnode.h"
+#include "render/instancednode.h"
+#include "render/itemlighting.h"
 
 #ifdef _X
 #undef _X
@@ -128,7 +129,8 @@ void copyVertexData(const std::shared_ptr<gameplay::Mesh>& mesh, const gsl::not_
                     BOOST_ASSERT(outMesh->HasTextureCoords(0));
                     outMesh->mTextureCoords[0][i].x = v[0];
                     outMesh->mTextureCoords[0][i].y = v[1];
-                    outMesh->mTextureCoords[0][i].z = 0;
+                    // level geometry stores the texture array layer here
+                    outMesh->mTextureCoords[0][i].z = attrib.second.getSize() > 2 ? v[2] : 0;
                 }
                 else if( attrib.first == VERTEX_ATTRIBUTE_COLOR_NAME )
                 {
@@ -148,19 +150,62 @@ void copyVertexData(const std::shared_ptr<gameplay::Mesh>& mesh, const gsl::not_
 
 
 template<typename T>
-void copyIndices(const std::shared_ptr<gameplay::MeshPart>& part, const gsl::not_null<aiMesh*>& outMesh)
+void readIndices(const std::shared_ptr<gameplay::MeshPart>& part, std::vector<uint32_t>& indices)
 {
     const T* data = static_cast<const T*>(part->map());
-    for( size_t fi = 0; fi < part->getIndexCount() / 3; ++fi )
+    std::copy_n(data, part->getIndexCount(), std::back_inserter(indices));
+    part->unmap();
+}
+
+
+std::vector<uint32_t> readIndices(const std::shared_ptr<gameplay::MeshPart>& part)
+{
+    std::vector<uint32_t> indices;
+    indices.reserve(part->getIndexCount());
+
+    switch( part->getIndexFormat() )
+    {
+        case gameplay::gl::TypeTraits<uint8_t>::TypeId:
+            readIndices<uint8_t>(part, indices);
+            break;
+        case gameplay::gl::TypeTraits<uint16_t>::TypeId:
+            readIndices<uint16_t>(part, indices);
+            break;
+        case gameplay::gl::TypeTraits<uint32_t>::TypeId:
+            readIndices<uint32_t>(part, indices);
+            break;
+        default:
+            break;
+    }
+
+    return indices;
+}
+
+
+void copyFaces(const std::vector<uint32_t>& indices, const gsl::not_null<aiMesh*>& outMesh)
+{
+    BOOST_ASSERT(indices.size() % 3 == 0);
+
+    outMesh->mNumFaces = gsl::narrow<uint32_t>(indices.size() / 3);
+    outMesh->mFaces = new aiFace[outMesh->mNumFaces];
+    for( size_t fi = 0; fi < outMesh->mNumFaces; ++fi )
     {
-        BOOST_ASSERT(fi < outMesh->mNumFaces);
         outMesh->mFaces[fi].mNumIndices = 3;
         outMesh->mFaces[fi].mIndices = new unsigned int[3];
-        outMesh->mFaces[fi].mIndices[0] = data[3 * fi + 0];
-        outMesh->mFaces[fi].mIndices[1] = data[3 * fi + 1];
-        outMesh->mFaces[fi].mIndices[2] = data[3 * fi + 2];
+        outMesh->mFaces[fi].mIndices[0] = indices[3 * fi + 0];
+        outMesh->mFaces[fi].mIndices[1] = indices[3 * fi + 1];
+        outMesh->mFaces[fi].mIndices[2] = indices[3 * fi + 2];
     }
-    part->unmap();
+}
+
+
+bool containsMaterial(const std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& materials,
+                      const std::shared_ptr<gameplay::Material>& material)
+{
+    return std::any_of(materials.begin(), materials.end(), [&material](const auto& entry)
+                       {
+                           return entry.second == material;
+                       });
 }
 
 
@@ -267,11 +312,9 @@ std::shared_ptr<gameplay::Material> Converter::readMaterial(const boost::filesys
 
     auto material = std::make_shared<gameplay::Material>(shaderProgram);
     material->getParameter("u_diffuseTexture")->set(texture);
-    material->getParameter("u_worldViewProjectionMatrix")->bindWorldViewProjectionMatrix();
     material->getParameter("u_modelMatrix")->bindModelMatrix();
-    material->getParameter("u_baseLight")->bind(&engine::items::ItemNode::lightBaseBinder);
-    material->getParameter("u_baseLightDiff")->bind(&engine::items::ItemNode::lightBaseDiffBinder);
-    material->getParameter("u_lightPosition")->bind(&engine::items::ItemNode::lightPositionBinder);
+    render::ItemLighting::bindDefaults(*material);
+    render::InstancedNode::bindDefaults(*material);
     material->initStateBlockDefaults();
 
     return material;
@@ -348,157 +391,72 @@ std::shared_ptr<gameplay::Model> Converter::readModel(const boost::filesystem::p
 }
 
 
-void Converter::write(const std::shared_ptr<gameplay::Model>& model,
-                      const std::string& baseName,
-                      const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
-                      const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2,
-                      const glm::vec3& ambientColor) const
+std::shared_ptr<aiScene> Converter::createScene(const std::shared_ptr<gameplay::Model>& model,
+                                                const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
+                                                const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2,
+                                                const glm::vec3& ambientColor) const
 {
     Expects(model != nullptr);
 
-    auto fullPath = m_basePath / baseName;
-
-    Assimp::Exporter exporter;
-    std::string formatIdentifier;
-    for( size_t i = 0; i < exporter.GetExportFormatCount(); ++i )
-    {
-        auto descr = exporter.GetExportFormatDescription(i);
-        BOOST_ASSERT(descr != nullptr);
-
-        std::string exporterExtension = std::string(".") + descr->fileExtension;
-
-        if( exporterExtension == fullPath.extension().string() )
-        {
-            formatIdentifier = descr->id;
-            break;
-        }
-    }
-
-    if( formatIdentifier.empty() )
-    {
-        BOOST_LOG_TRIVIAL(error) << "Failed to find an exporter for the supplied file extension";
-        BOOST_LOG_TRIVIAL(info) << "Here's the list of registered exporters";
+    std::shared_ptr<aiScene> scene = std::make_shared<aiScene>();
+    BOOST_ASSERT(scene->mRootNode == nullptr);
+    scene->mRootNode = new aiNode();
 
-        for( size_t i = 0; i < exporter.GetExportFormatCount(); ++i )
-        {
-            auto descr = exporter.GetExportFormatDescription(i);
-            BOOST_ASSERT(descr != nullptr);
+    convert(*scene, *scene->mRootNode, model, mtlMap1, mtlMap2, ambientColor);
 
-            BOOST_LOG_TRIVIAL(info) << descr->description << ", extension `" << descr->fileExtension << "`, id `" << descr->id << "`";
-        }
+    return scene;
+}
 
-        BOOST_THROW_EXCEPTION(std::runtime_error("Failed to find an exporter for the supplied file extension"));
-    }
 
-    std::unique_ptr<aiScene> scene = std::make_unique<aiScene>();
+std::shared_ptr<aiScene> Converter::createScene(const std::vector<Room>& rooms,
+                                                const std::vector<Box>& boxes,
+                                                const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
+                                                const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2) const
+{
+    std::shared_ptr<aiScene> scene = std::make_shared<aiScene>();
     BOOST_ASSERT(scene->mRootNode == nullptr);
     scene->mRootNode = new aiNode();
 
+    for( const auto& room : rooms )
     {
-        size_t totalPartCount = 0;
-        for( const auto& mesh : model->getMeshes() )
-        {
-            totalPartCount += mesh->getPartCount();
-        }
-
-        scene->mNumMaterials = totalPartCount;
-        scene->mMaterials = new aiMaterial*[totalPartCount];
-        std::fill_n(scene->mMaterials, totalPartCount, nullptr);
-
-        scene->mNumMeshes = totalPartCount;
-        scene->mMeshes = new aiMesh*[totalPartCount];
-        std::fill_n(scene->mMeshes, totalPartCount, nullptr);
-
-        scene->mRootNode->mNumMeshes = totalPartCount;
-        scene->mRootNode->mMeshes = new unsigned int[totalPartCount];
-        for( size_t i = 0; i < totalPartCount; ++i )
-            scene->mRootNode->mMeshes[i] = gsl::narrow<uint32_t>(i);
-    }
+        auto node = convert(*scene, *room.node, mtlMap1, mtlMap2, glm::vec3{room.getAmbientBrightness()});
+        if( node == nullptr )
+            continue;
 
-    for( size_t mi = 0, globalPartIndex = 0; mi < model->getMeshes().size(); ++mi )
-    {
-        const auto& mesh = model->getMeshes()[mi];
+        append(scene->mRootNode->mChildren, scene->mRootNode->mNumChildren, node);
+        append(scene->mRootNode->mChildren, scene->mRootNode->mNumChildren, convert(*scene, room.sectors, boxes))->mName = room.node->getId() + ":boxes";
 
-        for( size_t pi = 0; pi < mesh->getPartCount(); ++pi , ++globalPartIndex )
+        size_t lightId = 0;
+        for( const auto& light : room.lights )
         {
-            BOOST_ASSERT(globalPartIndex < scene->mNumMaterials);
-            BOOST_ASSERT(globalPartIndex < scene->mNumMeshes);
-            const std::shared_ptr<gameplay::MeshPart>& part = mesh->getPart(pi);
-
-            scene->mMeshes[globalPartIndex] = new aiMesh();
-            aiMesh* outMesh = scene->mMeshes[globalPartIndex];
-
-            allocateElementMemory(mesh, outMesh);
-            copyVertexData(mesh, outMesh);
-
-            BOOST_ASSERT(part->getPrimitiveType() == GL_TRIANGLES && part->getIndexCount() % 3 == 0);
-            outMesh->mMaterialIndex = gsl::narrow<uint32_t>(globalPartIndex);
-            scene->mMaterials[globalPartIndex] = new aiMaterial();
-            scene->mMaterials[globalPartIndex]->AddProperty(new aiColor4D(ambientColor.r, ambientColor.g, ambientColor.b, 1), 1, AI_MATKEY_COLOR_AMBIENT);
-
-            {
-                // try to find the texture for our material
-
-                using Entry = decltype(*mtlMap1.begin());
-                auto finder = [&part](const Entry& entry)
-                {
-                    return entry.second == part->getMaterial();
-                };
-
-                auto texIt = std::find_if(mtlMap1.begin(), mtlMap1.end(), finder);
-
-                bool found = false;
-                if( texIt != mtlMap1.end() )
-                {
-                    scene->mMaterials[globalPartIndex]->AddProperty(new aiString(makeTextureName(texIt->first.tileAndFlag & TextureIndexMask) + ".png"), AI_MATKEY_TEXTURE_DIFFUSE(0));
-                    found = true;
-                }
-
-                if( !found )
-                {
-                    texIt = std::find_if(mtlMap2.begin(), mtlMap2.end(), finder);
-                    if( texIt != mtlMap2.end() )
-                    {
-                        scene->mMaterials[globalPartIndex]->AddProperty(new aiString(makeTextureName(texIt->first.tileAndFlag & TextureIndexMask) + ".png"), AI_MATKEY_TEXTURE_DIFFUSE(0));
-                    }
-                }
-            }
-
-            outMesh->mNumFaces = gsl::narrow<uint32_t>(part->getIndexCount() / 3);
-            outMesh->mFaces = new aiFace[outMesh->mNumFaces];
-
-            switch( part->getIndexFormat() )
-            {
-                case gameplay::gl::TypeTraits<uint8_t>::TypeId:
-                    copyIndices<uint8_t>(part, outMesh);
-                    break;
-                case gameplay::gl::TypeTraits<uint16_t>::TypeId:
-                    copyIndices<uint16_t>(part, outMesh);
-                    break;
-                case gameplay::gl::TypeTraits<uint32_t>::TypeId:
-                    copyIndices<uint32_t>(part, outMesh);
-                    break;
-                default:
-                    break;
-            }
+            auto outLight = append(scene->mLights, scene->mNumLights, new aiLight());
+            outLight->mName = room.node->getId() + "_light:" + std::to_string(lightId++);
+            outLight->mType = aiLightSource_POINT;
+            outLight->mColorDiffuse.r = light.getBrightness();
+            outLight->mColorDiffuse.g = light.getBrightness();
+            outLight->mColorDiffuse.b = light.getBrightness();
+            outLight->mColorSpecular = outLight->mColorDiffuse;
+            outLight->mColorAmbient = outLight->mColorDiffuse;
+            // out = 1 / ( a * d*d )
+            // Must be 1/2 at the light radius, so we need to fulfill 2 = a * r*r => a = 2/(r*r)
+            const auto r = gsl::narrow_cast<float>(light.radius) / SectorSize;
+            outLight->mAttenuationConstant = 0;
+            outLight->mAttenuationLinear = 0;
+            outLight->mAttenuationQuadratic = 2 / (r * r);
 
-            if( outMesh->mNormals != nullptr && isnan(outMesh->mNormals[0].x) )
-            {
-                delete[] outMesh->mNormals;
-                outMesh->mNormals = nullptr;
-            }
+            auto lightNode = append(node->mChildren, node->mNumChildren, new aiNode(outLight->mName.C_Str()));
+            const auto p = light.position.toRenderSystem() - room.position.toRenderSystem();
+            lightNode->mTransformation.a4 = p.x / SectorSize;
+            lightNode->mTransformation.b4 = p.y / SectorSize;
+            lightNode->mTransformation.c4 = p.z / SectorSize;
         }
     }
 
-    exporter.Export(scene.get(), formatIdentifier.c_str(), fullPath.string(), aiProcess_JoinIdenticalVertices | aiProcess_ValidateDataStructure | aiProcess_FlipUVs);
+    return scene;
 }
 
 
-void Converter::write(const std::vector<Room>& rooms,
-                      const std::vector<Box>& boxes,
-                      const std::string& baseName,
-                      const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
-                      const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2) const
+void Converter::write(const aiScene& scene, const std::string& baseName) const
 {
     auto fullPath = m_basePath / baseName;
 
@@ -534,46 +492,7 @@ void Converter::write(const std::vector<Room>& rooms,
         BOOST_THROW_EXCEPTION(std::runtime_error("Failed to find an exporter for the supplied file extension"));
     }
 
-    std::unique_ptr<aiScene> scene = std::make_unique<aiScene>();
-    BOOST_ASSERT(scene->mRootNode == nullptr);
-    scene->mRootNode = new aiNode();
-
-    for( const auto& room : rooms )
-    {
-        auto node = convert(*scene, *room.node, mtlMap1, mtlMap2, glm::vec3{room.getAmbientBrightness()});
-        if( node == nullptr )
-            continue;
-
-        append(scene->mRootNode->mChildren, scene->mRootNode->mNumChildren, node);
-        append(scene->mRootNode->mChildren, scene->mRootNode->mNumChildren, convert(*scene, room.sectors, boxes))->mName = room.node->getId() + ":boxes";
-
-        size_t lightId = 0;
-        for( const auto& light : room.lights )
-        {
-            auto outLight = append(scene->mLights, scene->mNumLights, new aiLight());
-            outLight->mName = room.node->getId() + "_light:" + std::to_string(lightId++);
-            outLight->mType = aiLightSource_POINT;
-            outLight->mColorDiffuse.r = light.getBrightness();
-            outLight->mColorDiffuse.g = light.getBrightness();
-            outLight->mColorDiffuse.b = light.getBrightness();
-            outLight->mColorSpecular = outLight->mColorDiffuse;
-            outLight->mColorAmbient = outLight->mColorDiffuse;
-            // out = 1 / ( a * d*d )
-            // Must be 1/2 at the light radius, so we need to fulfill 2 = a * r*r => a = 2/(r*r)
-            const auto r = gsl::narrow_cast<float>(light.radius) / SectorSize;
-            outLight->mAttenuationConstant = 0;
-            outLight->mAttenuationLinear = 0;
-            outLight->mAttenuationQuadratic = 2 / (r * r);
-
-            auto lightNode = append(node->mChildren, node->mNumChildren, new aiNode(outLight->mName.C_Str()));
-            const auto p = light.position.toRenderSystem() - room.position.toRenderSystem();
-            lightNode->mTransformation.a4 = p.x / SectorSize;
-            lightNode->mTransformation.b4 = p.y / SectorSize;
-            lightNode->mTransformation.c4 = p.z / SectorSize;
-        }
-    }
-
-    exporter.Export(scene.get(), formatIdentifier.c_str(), fullPath.string(), aiProcess_JoinIdenticalVertices | aiProcess_ValidateDataStructure | aiProcess_FlipUVs);
+    exporter.Export(&scene, formatIdentifier.c_str(), fullPath.string(), aiProcess_JoinIdenticalVertices | aiProcess_ValidateDataStructure | aiProcess_FlipUVs);
 }
 
 
@@ -589,7 +508,30 @@ aiNode* Converter::convert(aiScene& scene,
     bool hasContent = false;
     if( auto sourceModel = std::dynamic_pointer_cast<gameplay::Model>(sourceNode.getDrawable()) )
     {
-        convert(scene, *outNode, sourceModel, mtlMap1, mtlMap2, ambientColor);
+        if( const auto instancedNode = dynamic_cast<const render::InstancedNode*>(&sourceNode) )
+        {
+            // the instances are exported as separate nodes sharing the meshes
+            const auto firstMesh = scene.mNumMeshes;
+            for( size_t i = 0; i < instancedNode->getInstanceCount(); ++i )
+            {
+                auto instanceNode = std::make_unique<aiNode>(sourceNode.getId() + ":" + std::to_string(i));
+                ::convert(instanceNode->mTransformation, instancedNode->getInstanceMatrix(i));
+                if( i == 0 )
+                {
+                    convert(scene, *instanceNode, sourceModel, mtlMap1, mtlMap2, ambientColor);
+                }
+                else
+                {
+                    for( auto mesh = firstMesh; mesh < scene.mNumMeshes; ++mesh )
+                        append(instanceNode->mMeshes, instanceNode->mNumMeshes, mesh);
+                }
+                append(outNode->mChildren, outNode->mNumChildren, instanceNode.release());
+            }
+        }
+        else
+        {
+            convert(scene, *outNode, sourceModel, mtlMap1, mtlMap2, ambientColor);
+        }
         hasContent = true;
     }
 
@@ -624,69 +566,59 @@ void Converter::convert(aiScene& scene,
         for( size_t pi = 0; pi < inMesh->getPartCount(); ++pi )
         {
             const std::shared_ptr<gameplay::MeshPart>& inPart = inMesh->getPart(pi);
+            BOOST_ASSERT(inPart->getPrimitiveType() == GL_TRIANGLES && inPart->getIndexCount() % 3 == 0);
 
-            append(outNode.mMeshes, outNode.mNumMeshes, scene.mNumMeshes);
-            auto outMesh = append(scene.mMeshes, scene.mNumMeshes, new aiMesh());
+            const auto indices = readIndices(inPart);
 
-            allocateElementMemory(inMesh, outMesh);
-            copyVertexData(inMesh, outMesh);
+            // Level materials sample from the texture array, with the layer taken from the 3rd texture
+            // coordinate, so a single part may use several texture pages.  The pages are exported as
+            // separate images, so such parts are split into one mesh per page.
+            std::map<int, std::vector<uint32_t>> indicesByLayer;
+            if( containsMaterial(mtlMap1, inPart->getMaterial()) || containsMaterial(mtlMap2, inPart->getMaterial()) )
+            {
+                aiMesh layerSource;
+                allocateElementMemory(inMesh, &layerSource);
+                copyVertexData(inMesh, &layerSource);
+                BOOST_ASSERT(layerSource.HasTextureCoords(0));
 
-            BOOST_ASSERT(inPart->getPrimitiveType() == GL_TRIANGLES && inPart->getIndexCount() % 3 == 0);
-            outMesh->mMaterialIndex = scene.mNumMaterials;
-            auto outMaterial = append(scene.mMaterials, scene.mNumMaterials, new aiMaterial());
-            outMaterial->AddProperty(new aiColor4D(ambientColor.r, ambientColor.g, ambientColor.b, 1), 1, AI_MATKEY_COLOR_AMBIENT);
+                for( size_t i = 0; i < indices.size(); i += 3 )
+                {
+                    const auto layer = static_cast<int>(std::lround(layerSource.mTextureCoords[0][indices[i]].z));
+                    auto& layerIndices = indicesByLayer[layer];
+                    layerIndices.insert(layerIndices.end(), &indices[i], &indices[i] + 3);
+                }
+            }
+            else
+            {
+                // no texture known for this material
+                indicesByLayer[-1] = indices;
+            }
 
+            for( const auto& layerAndIndices : indicesByLayer )
             {
-                // try to find the texture for our material
+                append(outNode.mMeshes, outNode.mNumMeshes, scene.mNumMeshes);
+                auto outMesh = append(scene.mMeshes, scene.mNumMeshes, new aiMesh());
 
-                using Entry = decltype(*mtlMap1.begin());
-                auto finder = [&inPart](const Entry& entry)
-                {
-                    return entry.second == inPart->getMaterial();
-                };
+                allocateElementMemory(inMesh, outMesh);
+                copyVertexData(inMesh, outMesh);
 
-                auto texIt = std::find_if(mtlMap1.begin(), mtlMap1.end(), finder);
+                outMesh->mMaterialIndex = scene.mNumMaterials;
+                auto outMaterial = append(scene.mMaterials, scene.mNumMaterials, new aiMaterial());
+                outMaterial->AddProperty(new aiColor4D(ambientColor.r, ambientColor.g, ambientColor.b, 1), 1, AI_MATKEY_COLOR_AMBIENT);
 
-                bool found = false;
-                if( texIt != mtlMap1.end() )
+                if( layerAndIndices.first >= 0 )
                 {
-                    outMaterial->AddProperty(new aiString(makeTextureName(texIt->first.tileAndFlag & TextureIndexMask) + ".png"), AI_MATKEY_TEXTURE_DIFFUSE(0));
-                    found = true;
+                    outMaterial->AddProperty(new aiString(makeTextureName(layerAndIndices.first) + ".png"), AI_MATKEY_TEXTURE_DIFFUSE(0));
                 }
 
-                if( !found )
+                copyFaces(layerAndIndices.second, outMesh);
+
+                if( outMesh->mNormals != nullptr && isnan(outMesh->mNormals[0].x) )
                 {
-                    texIt = std::find_if(mtlMap2.begin(), mtlMap2.end(), finder);
-                    if( texIt != mtlMap2.end() )
-                    {
-                        outMaterial->AddProperty(new aiString(makeTextureName(texIt->first.tileAndFlag & TextureIndexMask) + ".png"), AI_MATKEY_TEXTURE_DIFFUSE(0));
-                    }
+                    delete[] outMesh->mNormals;
+                    outMesh->mNormals = nullptr;
                 }
             }
-
-            outMesh->mNumFaces = gsl::narrow<uint32_t>(inPart->getIndexCount() / 3);
-            outMesh->mFaces = new aiFace[outMesh->mNumFaces];
-
-            switch( inPart->getIndexFormat() )
-            {
-                case gameplay::gl::TypeTraits<uint8_t>::TypeId:
-                    copyIndices<uint8_t>(inPart, outMesh);
-                    break;
-                case gameplay::gl::TypeTraits<uint16_t>::TypeId:
-                    copyIndices<uint16_t>(inPart, outMesh);
-                    break;
-                case gameplay::gl::TypeTraits<uint32_t>::TypeId:
-                    copyIndices<uint32_t>(inPart, outMesh);
-                    break;
-                default:
-                    break;
-            }
-
-            if( outMesh->mNormals != nullptr && isnan(outMesh->mNormals[0].x) )
-            {
-                delete[] outMesh->mNormals;
-                outMesh->mNormals = nullptr;
-            }
         }
     }
 }
@@ -48,23 +48,31 @@ public:
 
     std::shared_ptr<gameplay::Model> readModel(const boost::filesystem::path& path, const std::shared_ptr<gameplay::ShaderProgram>& shaderProgram, const glm::vec3& ambientColor) const;
 
-    void write(const std::shared_ptr<gameplay::Model>& model,
-               const std::string& baseName,
-               const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
-               const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2,
-               const glm::vec3& ambientColor) const;
-
-    void write(const std::vector<Room>& rooms,
-               const std::vector<Box>& boxes,
-               const std::string& baseName,
-               const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
-               const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2) const;
+    /**
+     * @brief Converts a model for exporting it with write(const aiScene&, const std::string&).
+     *
+     * The mesh data is read back from the GL buffers, so this must be called on the GL thread.
+     */
+    std::shared_ptr<aiScene> createScene(const std::shared_ptr<gameplay::Model>& model,
+                                         const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
+                                         const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2,
+                                         const glm::vec3& ambientColor) const;
+
+    //! @copydoc createScene(const std::shared_ptr<gameplay::Model>&, const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>&, const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>&, const glm::vec3&) const
+    std::shared_ptr<aiScene> createScene(const std::vector<Room>& rooms,
+                                         const std::vector<Box>& boxes,
+                                         const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
+                                         const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap2) const;
+
+    //! Exports a scene in the format given by the extension of @a baseName; may be called from any thread.
+    void write(const aiScene& scene, const std::string& baseName) const;
 
     void write(const std::string& filename, const YAML::Node& tree) const;
 
-private:
     static std::string makeTextureName(size_t id);
 
+private:
+
     aiNode* convert(aiScene& scene,
                     const gameplay::Node& sourceNode,
                     const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& mtlMap1,
@@ -1,14 +1,20 @@
 #include "datatypes.h"
 
 #include "level/level.h"
+#include "render/instancednode.h"
 #include "render/textureanimator.h"
+#include "render/vertexcache.h"
 #include "util/vmath.h"
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <boost/functional/hash.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/range/adaptors.hpp>
 
+#include <cstring>
+#include <unordered_map>
+
 
 namespace loader
 {
@@ -20,6 +26,10 @@ namespace loader
             glm::vec3 position;
             glm::vec4 color;
             glm::vec3 normal{0.0f};
+            //! The 3rd component is the texture array layer
+            glm::vec3 uv;
+            //! See render::TextureAnimator::getVertexAttribute()
+            glm::vec3 textureAnimation{0.0f};
 
 
             static const gameplay::ext::StructuredVertexBuffer::AttributeMapping& getFormat()
@@ -27,17 +37,38 @@ namespace loader
                 static const gameplay::ext::StructuredVertexBuffer::AttributeMapping attribs{
                     { VERTEX_ATTRIBUTE_POSITION_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::position } },
                     { VERTEX_ATTRIBUTE_NORMAL_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::normal } },
-                    { VERTEX_ATTRIBUTE_COLOR_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::color } }
+                    { VERTEX_ATTRIBUTE_COLOR_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::color } },
+                    { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::uv } },
+                    { VERTEX_ATTRIBUTE_TEXTURE_ANIMATION_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::textureAnimation } }
                 };
 
                 return attribs;
             }
+
+
+            bool operator==(const RenderVertex& rhs) const
+            {
+                return std::memcmp(this, &rhs, sizeof(RenderVertex)) == 0;
+            }
         };
 #pragma pack(pop)
 
+
+        struct RenderVertexHash
+        {
+            size_t operator()(const RenderVertex& vertex) const
+            {
+                static_assert(sizeof(RenderVertex) % sizeof(float) == 0, "Invalid vertex structure");
+                const auto data = reinterpret_cast<const float*>(&vertex);
+                return boost::hash_range(data, data + sizeof(RenderVertex) / sizeof(float));
+            }
+        };
+
+
         struct MeshPart
         {
-            using IndexBuffer = std::vector<uint16_t>;
+            //! Narrowed to 16 bits when uploaded if the mesh is small enough, see RenderModel::toModel()
+            using IndexBuffer = std::vector<uint32_t>;
             static_assert(std::is_unsigned<IndexBuffer::value_type>::value, "Index buffer entries must be unsigned");
 
             IndexBuffer indices;
@@ -52,17 +83,29 @@ namespace loader
 
             std::shared_ptr<gameplay::Model> toModel(const gsl::not_null<std::shared_ptr<gameplay::Mesh>>& mesh)
             {
-                for( const MeshPart& localPart : m_parts )
+                const auto vertexCount = mesh->getBuffer(0).getVertexCount();
+                for( MeshPart& localPart : m_parts )
                 {
 #ifndef NDEBUG
                     for( auto idx : localPart.indices )
                     {
-                        BOOST_ASSERT(idx < mesh->getBuffer(0).getVertexCount());
+                        BOOST_ASSERT(idx < vertexCount);
                     }
 #endif
 
-                    auto part = mesh->addPart(GL_TRIANGLES, gameplay::gl::TypeTraits<decltype(localPart.indices[0])>::TypeId, localPart.indices.size(), true);
-                    part->setIndexData(localPart.indices.data(), 0, 0);
+                    render::optimizeVertexCache(localPart.indices, vertexCount);
+
+                    if( vertexCount <= std::numeric_limits<uint16_t>::max() + size_t(1) )
+                    {
+                        const std::vector<uint16_t> indices(localPart.indices.begin(), localPart.indices.end());
+                        auto part = mesh->addPart(GL_TRIANGLES, gameplay::gl::TypeTraits<uint16_t>::TypeId, indices.size(), false);
+                        part->setIndexData(indices.data(), 0, 0);
+                    }
+                    else
+                    {
+                        auto part = mesh->addPart(GL_TRIANGLES, gameplay::gl::TypeTraits<uint32_t>::TypeId, localPart.indices.size(), false);
+                        part->setIndexData(localPart.indices.data(), 0, 0);
+                    }
                 }
 
                 auto model = std::make_shared<gameplay::Model>();
@@ -82,136 +125,146 @@ namespace loader
     std::shared_ptr<gameplay::Node> Room::createSceneNode(gameplay::Game* game,
                                                           size_t roomId,
                                                           const level::Level& level,
-                                                          const std::vector<std::shared_ptr<gameplay::gl::Texture> >& textures,
+                                                          const std::shared_ptr<gameplay::gl::Texture>& textures,
                                                           const std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& materials,
                                                           const std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& waterMaterials,
                                                           const std::vector<std::shared_ptr<gameplay::Model>>& staticMeshes,
-                                                          render::TextureAnimator& animator)
+                                                          const render::TextureAnimator& animator,
+                                                          size_t& faceVertexCount)
     {
         RenderModel renderModel;
-        std::map<TextureLayoutProxy::TextureKey, size_t> texBuffers;
+        // Faces sharing a material share a part, regardless of the texture page they're using
+        std::map<std::shared_ptr<gameplay::Material>, size_t> materialParts;
         std::vector<RenderVertex> vbuf;
-        std::vector<glm::vec2> uvCoords;
+        // Faces sharing an edge usually share their vertices, too
+        std::unordered_map<RenderVertex, uint32_t, RenderVertexHash> vertexIndices;
+        const auto addVertex = [&vbuf, &vertexIndices, &faceVertexCount](const RenderVertex& vertex)
+        {
+            ++faceVertexCount;
+            const auto it = vertexIndices.emplace(vertex, gsl::narrow<uint32_t>(vbuf.size()));
+            if( it.second )
+                vbuf.emplace_back(vertex);
+            return it.first->second;
+        };
+        const auto textureIndexMask = level.getTextureIndexMask();
         auto mesh = std::make_shared<gameplay::Mesh>(RenderVertex::getFormat(), false, "Room:" + boost::lexical_cast<std::string>(roomId));
 
         for( const QuadFace& quad : rectangles )
         {
             const TextureLayoutProxy& proxy = level.m_textureProxies.at(quad.proxyId);
 
-            if( texBuffers.find(proxy.textureKey) == texBuffers.end() )
+            auto it = isWaterRoom() ? waterMaterials.find(proxy.textureKey) : materials.find(proxy.textureKey);
+            Expects(it != (isWaterRoom() ? waterMaterials.end() : materials.end()));
+            if( materialParts.find(it->second) == materialParts.end() )
             {
-                texBuffers[proxy.textureKey] = renderModel.m_parts.size();
+                materialParts[it->second] = renderModel.m_parts.size();
                 renderModel.m_parts.emplace_back();
-                auto it = isWaterRoom() ? waterMaterials.find(proxy.textureKey) : materials.find(proxy.textureKey);
-                Expects(it != (isWaterRoom() ? waterMaterials.end() : materials.end()));
                 renderModel.m_parts.back().material = it->second;
             }
-            const auto partId = texBuffers[proxy.textureKey];
+            const auto partId = materialParts[it->second];
+            const auto layer = static_cast<float>(proxy.textureKey.tileAndFlag & textureIndexMask);
 
-            const auto firstVertex = vbuf.size();
+            uint32_t faceIndices[4];
             for( int i = 0; i < 4; ++i )
             {
                 RenderVertex iv;
                 iv.position = vertices[quad.vertices[i]].position.toRenderSystem();
                 iv.color = vertices[quad.vertices[i]].color;
-                uvCoords.push_back( proxy.uvCoordinates[i].toGl() );
-                vbuf.push_back(iv);
+                iv.uv = glm::vec3{proxy.uvCoordinates[i].toGl(), layer};
+                iv.textureAnimation = animator.getVertexAttribute(quad.proxyId, i);
+                faceIndices[i] = addVertex(iv);
             }
 
-            animator.registerVertex(quad.proxyId, mesh, 0, firstVertex + 0);
-            renderModel.m_parts[partId].indices.emplace_back(gsl::narrow<uint16_t>(firstVertex + 0));
-            animator.registerVertex(quad.proxyId, mesh, 1, firstVertex + 1);
-            renderModel.m_parts[partId].indices.emplace_back(gsl::narrow<uint16_t>(firstVertex + 1));
-            animator.registerVertex(quad.proxyId, mesh, 2, firstVertex + 2);
-            renderModel.m_parts[partId].indices.emplace_back(gsl::narrow<uint16_t>(firstVertex + 2));
-            animator.registerVertex(quad.proxyId, mesh, 0, firstVertex + 0);
-            renderModel.m_parts[partId].indices.emplace_back(gsl::narrow<uint16_t>(firstVertex + 0));
-            animator.registerVertex(quad.proxyId, mesh, 2, firstVertex + 2);
-            renderModel.m_parts[partId].indices.emplace_back(gsl::narrow<uint16_t>(firstVertex + 2));
-            animator.registerVertex(quad.proxyId, mesh, 3, firstVertex + 3);
-            renderModel.m_parts[partId].indices.emplace_back(gsl::narrow<uint16_t>(firstVertex + 3));
+            renderModel.m_parts[partId].indices.emplace_back(faceIndices[0]);
+            renderModel.m_parts[partId].indices.emplace_back(faceIndices[1]);
+            renderModel.m_parts[partId].indices.emplace_back(faceIndices[2]);
+            renderModel.m_parts[partId].indices.emplace_back(faceIndices[0]);
+            renderModel.m_parts[partId].indices.emplace_back(faceIndices[2]);
+            renderModel.m_parts[partId].indices.emplace_back(faceIndices[3]);
         }
         for( const Triangle& tri : triangles )
         {
             const TextureLayoutProxy& proxy = level.m_textureProxies.at(tri.proxyId);
 
-            if( texBuffers.find(proxy.textureKey) == texBuffers.end() )
+            auto it = isWaterRoom() ? waterMaterials.find(proxy.textureKey) : materials.find(proxy.textureKey);
+            Expects(it != (isWaterRoom() ? waterMaterials.end() : materials.end()));
+            if( materialParts.find(it->second) == materialParts.end() )
             {
-                texBuffers[proxy.textureKey] = renderModel.m_parts.size();
+                materialParts[it->second] = renderModel.m_parts.size();
                 renderModel.m_parts.emplace_back();
-                auto it = isWaterRoom() ? waterMaterials.find(proxy.textureKey) : materials.find(proxy.textureKey);
-                Expects(it != (isWaterRoom() ? waterMaterials.end() : materials.end()));
                 renderModel.m_parts.back().material = it->second;
             }
-            const auto partId = texBuffers[proxy.textureKey];
+            const auto partId = materialParts[it->second];
+            const auto layer = static_cast<float>(proxy.textureKey.tileAndFlag & textureIndexMask);
 
-            const auto firstVertex = vbuf.size();
+            uint32_t faceIndices[3];
             for( int i = 0; i < 3; ++i )
             {
                 RenderVertex iv;
                 iv.position = vertices[tri.vertices[i]].position.toRenderSystem();
                 iv.color = vertices[tri.vertices[i]].color;
-                uvCoords.push_back(proxy.uvCoordinates[i].toGl());
-                vbuf.push_back(iv);
+                iv.uv = glm::vec3{proxy.uvCoordinates[i].toGl(), layer};
+                iv.textureAnimation = animator.getVertexAttribute(tri.proxyId, i);
+                faceIndices[i] = addVertex(iv);
             }
 
-            animator.registerVertex(tri.proxyId, mesh, 0, firstVertex + 0);
-            renderModel.m_parts[partId].indices.emplace_back(gsl::narrow<uint16_t>(firstVertex + 0));
-            animator.registerVertex(tri.proxyId, mesh, 1, firstVertex + 1);
-            renderModel.m_parts[partId].indices.emplace_back(gsl::narrow<uint16_t>(firstVertex + 1));
-            animator.registerVertex(tri.proxyId, mesh, 2, firstVertex + 2);
-            renderModel.m_parts[partId].indices.emplace_back(gsl::narrow<uint16_t>(firstVertex + 2));
+            renderModel.m_parts[partId].indices.emplace_back(faceIndices[0]);
+            renderModel.m_parts[partId].indices.emplace_back(faceIndices[1]);
+            renderModel.m_parts[partId].indices.emplace_back(faceIndices[2]);
         }
 
         mesh->getBuffer(0).assign(vbuf);
 
-        static const gameplay::ext::StructuredVertexBuffer::AttributeMapping attribs{
-            { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME, gameplay::ext::VertexAttribute{ gameplay::ext::VertexAttribute::SingleAttribute<glm::vec2>{} } }
-        };
-
-        mesh->addBuffer(attribs, true);
-        mesh->getBuffer(1).assign(uvCoords);
-
         auto resModel = renderModel.toModel(mesh);
         node = std::make_shared<gameplay::Node>("Room:" + boost::lexical_cast<std::string>(roomId));
         node->setDrawable(resModel);
-        node->addMaterialParameterSetter("u_lightPosition", [](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
-        {
-            uniform.set(glm::vec3{0.0f});
-        });
-        node->addMaterialParameterSetter("u_baseLight", [](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
-        {
-            uniform.set(1.0f);
-        });
-        node->addMaterialParameterSetter("u_baseLightDiff", [](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
-        {
-            uniform.set(1.0f);
-        });
 
+        // static meshes sharing a mesh are drawn instanced, in groups of at most MaxInstances
+        std::map<uint32_t, std::vector<const RoomStaticMesh*>> staticMeshesById;
         for( const RoomStaticMesh& sm : this->staticMeshes )
+            staticMeshesById[sm.meshId].emplace_back(&sm);
+
+        staticMeshNodes.clear();
+        for( const auto& idAndStaticMeshes : staticMeshesById )
         {
-            auto idx = level.findStaticMeshIndexById(sm.meshId);
+            const auto idx = level.findStaticMeshIndexById(idAndStaticMeshes.first);
             BOOST_ASSERT(idx >= 0);
             BOOST_ASSERT(static_cast<size_t>(idx) < staticMeshes.size());
-            auto subNode = std::make_shared<gameplay::Node>("");
-            subNode->setDrawable(staticMeshes[idx]);
-            subNode->setLocalMatrix(glm::translate(glm::mat4{1.0f}, (sm.position - position).toRenderSystem()) * glm::rotate(glm::mat4{1.0f}, util::auToRad(sm.rotation), glm::vec3{0,-1,0}));
-
-            float brightness = 1 - (sm.darkness - 4096) / 8192.0f;
+            const StaticMesh* staticMesh = level.findStaticMeshById(idAndStaticMeshes.first);
+            BOOST_ASSERT(staticMesh != nullptr);
 
-            subNode->addMaterialParameterSetter("u_baseLight", [brightness](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
-            {
-                uniform.set(brightness);
-            });
-            subNode->addMaterialParameterSetter("u_baseLightDiff", [](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
+            const auto& group = idAndStaticMeshes.second;
+            for( size_t first = 0; first < group.size(); first += render::InstancedNode::MaxInstances )
             {
-                uniform.set(0.0f);
-            });
-            subNode->addMaterialParameterSetter("u_lightPosition", [](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
-            {
-                uniform.set(glm::vec3{ std::numeric_limits<float>::quiet_NaN() });
-            });
-            node->addChild(subNode);
+                const auto last = std::min(first + render::InstancedNode::MaxInstances, group.size());
+
+                std::vector<render::InstancedNode::Instance> instances;
+                boost::optional<gameplay::BoundingBox> groupBox;
+                for( size_t i = first; i < last; ++i )
+                {
+                    const RoomStaticMesh& sm = *group[i];
+
+                    render::InstancedNode::Instance instance;
+                    instance.translation = (sm.position - position).toRenderSystem();
+                    instance.rotation = util::auToRad(sm.rotation);
+                    instance.brightness = 1 - (sm.darkness - 4096) / 8192.0f;
+                    instances.emplace_back(instance);
+
+                    // the axes may be flipped by the rotation, and Y and Z are flipped in the render system
+                    const auto box = staticMesh->getVisibilityBox(sm.position, core::Angle{sm.rotation});
+                    const glm::vec3 renderMin{std::min(box.min.x, box.max.x), -std::max(box.min.y, box.max.y), -std::max(box.min.z, box.max.z)};
+                    const glm::vec3 renderMax{std::max(box.min.x, box.max.x), -std::min(box.min.y, box.max.y), -std::min(box.min.z, box.max.z)};
+                    if( groupBox )
+                        groupBox->merge(gameplay::BoundingBox{renderMin, renderMax});
+                    else
+                        groupBox = gameplay::BoundingBox{renderMin, renderMax};
+                }
+
+                auto subNode = std::make_shared<render::InstancedNode>("StaticMesh:" + std::to_string(idAndStaticMeshes.first),
+                                                                       staticMeshes[idx], instances);
+                node->addChild(subNode);
+                staticMeshNodes.emplace_back(subNode, *groupBox);
+            }
         }
         node->setLocalMatrix(glm::translate(glm::mat4{1.0f}, position.toRenderSystem()));
 
@@ -236,39 +289,52 @@ namespace loader
     }
 
 
-    gameplay::BoundingBox StaticMesh::getCollisionBox(const core::TRCoordinates& pos, core::Angle angle) const
+    namespace
     {
-        auto result = collision_box;
-
-        const auto axis = core::axisFromAngle(angle, 45_deg);
-        switch( *axis )
+        gameplay::BoundingBox alignBox(gameplay::BoundingBox box, const core::TRCoordinates& pos, core::Angle angle)
         {
-            case core::Axis::PosZ:
-                // nothing to do
-                break;
-            case core::Axis::PosX:
-                std::swap(result.min.x, result.min.z);
-                result.min.z *= -1;
-                std::swap(result.max.x, result.max.z);
-                result.max.z *= -1;
-                break;
-            case core::Axis::NegZ:
-                result.min.x *= -1;
-                result.min.z *= -1;
-                result.max.x *= -1;
-                result.max.z *= -1;
-                break;
-            case core::Axis::NegX:
-                std::swap(result.min.x, result.min.z);
-                result.min.x *= -1;
-                std::swap(result.max.x, result.max.z);
-                result.max.x *= -1;
-                break;
+            const auto axis = core::axisFromAngle(angle, 45_deg);
+            switch( *axis )
+            {
+                case core::Axis::PosZ:
+                    // nothing to do
+                    break;
+                case core::Axis::PosX:
+                    std::swap(box.min.x, box.min.z);
+                    box.min.z *= -1;
+                    std::swap(box.max.x, box.max.z);
+                    box.max.z *= -1;
+                    break;
+                case core::Axis::NegZ:
+                    box.min.x *= -1;
+                    box.min.z *= -1;
+                    box.max.x *= -1;
+                    box.max.z *= -1;
+                    break;
+                case core::Axis::NegX:
+                    std::swap(box.min.x, box.min.z);
+                    box.min.x *= -1;
+                    std::swap(box.max.x, box.max.z);
+                    box.max.x *= -1;
+                    break;
+            }
+
+            box.min += glm::vec3(pos.X, pos.Y, pos.Z);
+            box.max += glm::vec3(pos.X, pos.Y, pos.Z);
+            return box;
         }
+    }
+
+
+    gameplay::BoundingBox StaticMesh::getCollisionBox(const core::TRCoordinates& pos, core::Angle angle) const
+    {
+        return alignBox(collision_box, pos, angle);
+    }
 
-        result.min += glm::vec3(pos.X, pos.Y, pos.Z);
-        result.max += glm::vec3(pos.X, pos.Y, pos.Z);
-        return result;
+
+    gameplay::BoundingBox StaticMesh::getVisibilityBox(const core::TRCoordinates& pos, core::Angle angle) const
+    {
+        return alignBox(visibility_box, pos, angle);
     }
 
 
@@ -300,9 +366,13 @@ namespace loader
         if( (box.overlap_index & 0x8000) == 0 )
             return;
 
+        const auto oldOverlapIndex = box.overlap_index;
         if( height >= 0 )
             box.overlap_index &= ~0x4000;
         else
             box.overlap_index |= 0x4000;
+
+        if( box.overlap_index != oldOverlapIndex && ctrl.getLevel().m_routeCache != nullptr )
+            ctrl.getLevel().m_routeCache->invalidatePaths();
     }
 }
@@ -525,6 +525,15 @@ namespace loader
 
         uint16_t flags;
 
+        //! Rooms connected to this room by a portal, without duplicates; set up by the level
+        std::vector<const Room*> adjoiningRooms;
+
+        //! Items of the level data that are currently in this room, ordered by item id; maintained by the items
+        mutable std::vector<engine::items::ItemNode*> items;
+
+        //! Instanced scene nodes of the static meshes, with the boxes of all their instances in world space; set up by createSceneNode()
+        std::vector<std::pair<std::shared_ptr<gameplay::Node>, gameplay::BoundingBox>> staticMeshNodes;
+
 
         float getAmbientBrightness() const
         {
@@ -1050,11 +1059,13 @@ namespace loader
         }
 
 
+        //! @param faceVertexCount Incremented by the number of face vertices of the geometry, before they are deduplicated
         std::shared_ptr<gameplay::Node> createSceneNode(gameplay::Game* game, size_t roomId, const level::Level& level,
-                                                        const std::vector<std::shared_ptr<gameplay::gl::Texture>>& textures,
+                                                        const std::shared_ptr<gameplay::gl::Texture>& textures,
                                                         const std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& materials,
                                                         const std::map<loader::TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& waterMaterials,
-                                                        const std::vector<std::shared_ptr<gameplay::Model>>& staticMeshes, render::TextureAnimator& animator);
+                                                        const std::vector<std::shared_ptr<gameplay::Model>>& staticMeshes, const render::TextureAnimator& animator,
+                                                        size_t& faceVertexCount);
 
 
         const Sector* getSectorByAbsolutePosition(core::TRCoordinates position) const
@@ -1,8 +1,7 @@
 #pragma once
 
-#include <boost/iostreams/device/array.hpp>
-#include <boost/iostreams/device/file.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 #include <iostream>
 
@@ -17,6 +16,7 @@
 #endif
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <stdexcept>
 #include <vector>
@@ -41,55 +41,51 @@ struct TypeInfo
 
 namespace io
 {
-using DataStreamBuf = boost::iostreams::filtering_istreambuf;
-
+/**
+ * @brief Reads level data from a memory-mapped file or from a memory buffer.
+ *
+ * All accesses are plain pointer arithmetic on the mapped memory; reading vectors of plain
+ * integral or floating point values is a single bulk copy.
+ */
 class SDLReader
 {
     SDLReader(const SDLReader&) = delete;
     SDLReader& operator=(const SDLReader&) = delete;
 public:
-    explicit SDLReader(const std::shared_ptr<DataStreamBuf>& stream)
-        : m_memory()
-        , m_file()
-        , m_array()
-        , m_streamBuf(stream)
-        , m_stream(m_streamBuf.get())
-    {
-    }
-
-    SDLReader(SDLReader&& rhs)
-        : m_memory(std::move(rhs.m_memory))
-        , m_file(std::move(rhs.m_file))
-        , m_array(std::move(rhs.m_array))
-        , m_streamBuf(std::move(rhs.m_streamBuf))
-        , m_stream(m_streamBuf.get())
-    {
-    }
+    SDLReader(SDLReader&& rhs) = default;
 
     explicit SDLReader(const std::string& filename)
-        : m_memory()
-        , m_file(std::make_unique<boost::iostreams::file>(filename, std::ios::in | std::ios::binary, std::ios::in | std::ios::binary))
-        , m_array()
-        , m_streamBuf( std::make_shared<DataStreamBuf>( *m_file ) )
-        , m_stream(m_streamBuf.get())
     {
+        boost::system::error_code ec;
+        const auto fileSize = boost::filesystem::file_size(filename, ec);
+        if(ec)
+        {
+            BOOST_LOG_TRIVIAL(warning) << "Failed to open " << filename << ": " << ec.message();
+            return;
+        }
+
+        m_isOpen = true;
+        if(fileSize == 0)
+            return; // empty files cannot be mapped
+
+        m_file.open(filename);
+        m_data = m_file.data();
+        m_size = m_file.size();
     }
 
     explicit SDLReader(const std::vector<char>& data)
         : m_memory(data)
-        , m_file()
-        , m_array(std::make_unique<boost::iostreams::array>(m_memory.data(), m_memory.size()))
-        , m_streamBuf(std::make_shared<DataStreamBuf>(*m_array))
-        , m_stream(m_streamBuf.get())
+        , m_data(m_memory.data())
+        , m_size(m_memory.size())
+        , m_isOpen(true)
     {
     }
 
     explicit SDLReader(std::vector<char>&& data)
         : m_memory(std::move(data))
-        , m_file()
-        , m_array(std::make_unique<boost::iostreams::array>(m_memory.data(), m_memory.size()))
-        , m_streamBuf(std::make_shared<DataStreamBuf>(*m_array))
-        , m_stream(m_streamBuf.get())
+        , m_data(m_memory.data())
+        , m_size(m_memory.size())
+        , m_isOpen(true)
     {
     }
 
@@ -115,42 +111,37 @@ public:
 
     bool isOpen() const
     {
-        return !m_stream.bad();
+        return m_isOpen;
     }
 
-    std::streampos tell()
+    std::streampos tell() const
     {
-        return m_stream.tellg();
+        return static_cast<std::streamoff>(m_position);
     }
 
-    std::streamsize size()
+    std::streamsize size() const
     {
-        const auto pos = m_stream.tellg();
-        m_stream.seekg(0, std::ios::end);
-        const auto size = m_stream.tellg();
-        m_stream.seekg(pos, std::ios::beg);
-        return size;
+        return static_cast<std::streamsize>(m_size);
     }
 
     void skip(std::streamoff delta)
     {
-        m_stream.seekg(delta, std::ios::cur);
+        seek(tell() + delta);
     }
 
     void seek(std::streampos position)
     {
-        m_stream.seekg(position, std::ios::beg);
+        if(position < 0)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Seek before start of data"));
+
+        m_position = static_cast<size_t>(static_cast<std::streamoff>(position));
     }
 
     template<typename T>
     void readBytes(T* dest, size_t n)
     {
         static_assert(std::is_integral<T>::value && sizeof(T) == 1, "readBytes() only allowed for byte-compatible data");
-        m_stream.read(reinterpret_cast<char*>(dest), n);
-        if(static_cast<size_t>(m_stream.gcount()) != n)
-        {
-            BOOST_THROW_EXCEPTION(std::runtime_error("EOF unexpectedly reached"));
-        }
+        std::memcpy(dest, consume(n), n);
     }
 
     template<typename T>
@@ -200,43 +191,25 @@ public:
     template<typename T>
     void readVector(std::vector<T>& elements, size_t count)
     {
-        BOOST_LOG_TRIVIAL(debug) << "Reading " << count << " elements of type `" << detail::TypeInfo<T>().pretty_name() << "` (size " << sizeof(T) << ")";
-
-        elements.clear();
-        elements.reserve(count);
-        for(size_t i = 0; i < count; ++i)
-        {
-            elements.emplace_back(read<T>());
-        }
-    }
+        static_assert(std::is_integral<T>::value || std::is_floating_point<T>::value, "readVector() without a producer only allowed for plain values");
 
-    void readVector(std::vector<uint8_t>& elements, size_t count)
-    {
-        BOOST_LOG_TRIVIAL(debug) << "Reading " << count << " elements of type `" << detail::TypeInfo<uint8_t>().pretty_name() << "` (size " << sizeof(uint8_t) << ")";
+        BOOST_LOG_TRIVIAL(debug) << "Reading " << count << " elements of type `" << detail::TypeInfo<T>().pretty_name() << "` (size " << sizeof(T) << ")";
 
         elements.clear();
         elements.resize(count);
-        readBytes(elements.data(), count);
-    }
+        if(count == 0)
+            return;
 
-    void readVector(std::vector<int8_t>& elements, size_t count)
-    {
-        BOOST_LOG_TRIVIAL(debug) << "Reading " << count << " elements of type `" << detail::TypeInfo<int8_t>().pretty_name() << "` (size " << sizeof(int8_t) << ")";
-
-        elements.clear();
-        elements.resize(count);
-        readBytes(elements.data(), count);
+        std::memcpy(elements.data(), consume(count * sizeof(T)), count * sizeof(T));
+        for(T& element : elements)
+            SwapTraits<T, sizeof(T), true>::doSwap(element);
     }
 
     template<typename T>
     T read()
     {
         T result;
-        m_stream.read(reinterpret_cast<char*>(&result), sizeof(T));
-        if(m_stream.gcount() != sizeof(T))
-        {
-            BOOST_THROW_EXCEPTION(std::runtime_error("EOF unexpectedly reached"));
-        }
+        std::memcpy(&result, consume(sizeof(T)), sizeof(T));
 
         SwapTraits<T, sizeof(T), std::is_integral<T>::value || std::is_floating_point<T>::value>::doSwap(result);
 
@@ -275,10 +248,24 @@ public:
 private:
     // Do not change the order of these member variables.
     std::vector<char> m_memory;
-    std::unique_ptr<boost::iostreams::file> m_file;
-    std::unique_ptr<boost::iostreams::array> m_array;
-    std::shared_ptr<DataStreamBuf> m_streamBuf;
-    std::istream m_stream;
+    boost::iostreams::mapped_file_source m_file;
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_position = 0;
+    bool m_isOpen = false;
+
+    //! Returns a pointer to the next @a n bytes and advances the read position.
+    const char* consume(size_t n)
+    {
+        if(m_position > m_size || m_size - m_position < n)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error("EOF unexpectedly reached"));
+        }
+
+        const char* result = m_data + m_position;
+        m_position += n;
+        return result;
+    }
 
     template<typename T, int dataSize, bool isIntegral>
     struct SwapTraits
@@ -11,7 +11,12 @@ namespace loader
     {
         glm::vec3 position;
         glm::vec4 color;
-        glm::vec2 uv;
+        //! The 3rd component is the texture array layer
+        glm::vec3 uv;
+        //! See render::TextureAnimator::getVertexAttribute()
+        glm::vec3 textureAnimation{0.0f};
+        //! Only used by skinned models, see Level::getSkinnedModel()
+        float boneIndex = 0;
 
 
         static const gameplay::ext::StructuredVertexBuffer::AttributeMapping& getFormat()
@@ -19,7 +24,9 @@ namespace loader
             static const gameplay::ext::StructuredVertexBuffer::AttributeMapping attribs{
                 { VERTEX_ATTRIBUTE_POSITION_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::position } },
                 { VERTEX_ATTRIBUTE_COLOR_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::color } },
-                { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::uv } }
+                { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::uv } },
+                { VERTEX_ATTRIBUTE_TEXTURE_ANIMATION_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::textureAnimation } },
+                { VERTEX_ATTRIBUTE_BONE_INDEX_NAME, gameplay::ext::VertexAttribute{ &RenderVertex::boneIndex } }
             };
 
             return attribs;
@@ -32,7 +39,10 @@ namespace loader
         glm::vec3 position;
         glm::vec3 normal;
         glm::vec4 color;
-        glm::vec2 uv;
+        //! The 3rd component is the texture array layer
+        glm::vec3 uv;
+        glm::vec3 textureAnimation{0.0f};
+        float boneIndex = 0;
 
 
         static const gameplay::ext::StructuredVertexBuffer::AttributeMapping& getFormat()
@@ -41,7 +51,9 @@ namespace loader
                 { VERTEX_ATTRIBUTE_POSITION_NAME, gameplay::ext::VertexAttribute{ &RenderVertexWithNormal::position } },
                 { VERTEX_ATTRIBUTE_NORMAL_NAME, gameplay::ext::VertexAttribute{ &RenderVertexWithNormal::normal } },
                 { VERTEX_ATTRIBUTE_COLOR_NAME, gameplay::ext::VertexAttribute{ &RenderVertexWithNormal::color } },
-                { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME, gameplay::ext::VertexAttribute{ &RenderVertexWithNormal::uv } }
+                { VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME, gameplay::ext::VertexAttribute{ &RenderVertexWithNormal::uv } },
+                { VERTEX_ATTRIBUTE_TEXTURE_ANIMATION_NAME, gameplay::ext::VertexAttribute{ &RenderVertexWithNormal::textureAnimation } },
+                { VERTEX_ATTRIBUTE_BONE_INDEX_NAME, gameplay::ext::VertexAttribute{ &RenderVertexWithNormal::boneIndex } }
             };
 
             return attribs;
@@ -59,13 +71,15 @@ namespace loader
                                      bool dynamic,
                                      const std::vector<TextureLayoutProxy>& textureProxies,
                                      const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& materials,
+                                     uint16_t textureIndexMask,
                                      const std::shared_ptr<gameplay::Material>& colorMaterial,
                                      const Palette& palette,
-                                     render::TextureAnimator& animator,
+                                     const render::TextureAnimator& animator,
                                      const std::string& label)
         : m_hasNormals{withNormals}
         , m_textureProxies{textureProxies}
         , m_materials{materials}
+        , m_textureIndexMask{textureIndexMask}
         , m_colorMaterial{colorMaterial}
         , m_palette{palette}
         , m_animator{animator}
@@ -104,7 +118,7 @@ namespace loader
     }
 
 
-    void Mesh::ModelBuilder::append(const Mesh& mesh)
+    void Mesh::ModelBuilder::append(const Mesh& mesh, float boneIndex)
     {
         if( mesh.normals.empty() && m_hasNormals )
         BOOST_THROW_EXCEPTION(std::runtime_error("Trying to append a mesh with normals to a buffer without normals"));
@@ -122,18 +136,19 @@ namespace loader
                 for( int i = 0; i < 4; ++i )
                 {
                     RenderVertex iv;
+                    iv.boneIndex = boneIndex;
                     iv.position = mesh.vertices[quad.vertices[i]].toRenderSystem();
                     if(quad.vertices[i] < mesh.vertexDarknesses.size())
                         iv.color = glm::vec4(1 - mesh.vertexDarknesses[quad.vertices[i]] / 8192.0f);
                     else
                         iv.color = glm::vec4(1.0f);
-                    iv.uv = proxy.uvCoordinates[i].toGl();
+                    iv.uv = getUv(proxy, i);
+                    iv.textureAnimation = m_animator.getVertexAttribute(quad.proxyId, i);
                     append(iv);
                 }
 
                 for(auto j : { 0,1,2,0,2,3 })
                 {
-                    m_animator.registerVertex(quad.proxyId, m_mesh, j, firstVertex + j);
                     m_parts[partId].indices.emplace_back(firstVertex + j);
                 }
             }
@@ -146,12 +161,13 @@ namespace loader
                 for( int i = 0; i < 4; ++i )
                 {
                     RenderVertex iv;
+                    iv.boneIndex = boneIndex;
                     iv.position = mesh.vertices[quad.vertices[i]].toRenderSystem();
                     if(quad.vertices[i] < mesh.vertexDarknesses.size())
                         iv.color = glm::vec4(1 - mesh.vertexDarknesses[quad.vertices[i]] / 8192.0f);
                     else
                         iv.color = glm::vec4(1.0f);
-                    iv.uv = proxy.uvCoordinates[i].toGl();
+                    iv.uv = getUv(proxy, i);
                     append(iv);
                 }
 
@@ -165,23 +181,20 @@ namespace loader
                 const TextureLayoutProxy& proxy = m_textureProxies.at(tri.proxyId);
                 const auto partId = getPartForTexture(proxy);
 
-                const auto firstVertex = m_vertexCount;
                 for( int i = 0; i < 3; ++i )
                 {
                     RenderVertex iv;
+                    iv.boneIndex = boneIndex;
                     iv.position = mesh.vertices[tri.vertices[i]].toRenderSystem();
                     if(tri.vertices[i] < mesh.vertexDarknesses.size())
                         iv.color = glm::vec4(1 - mesh.vertexDarknesses[tri.vertices[i]] / 8192.0f);
                     else
                         iv.color = glm::vec4(1.0f);
-                    iv.uv = proxy.uvCoordinates[i].toGl();
+                    iv.uv = getUv(proxy, i);
+                    iv.textureAnimation = m_animator.getVertexAttribute(tri.proxyId, i);
                     m_parts[partId].indices.emplace_back(m_vertexCount);
                     append(iv);
                 }
-
-                m_animator.registerVertex(tri.proxyId, m_mesh, 0, firstVertex + 0);
-                m_animator.registerVertex(tri.proxyId, m_mesh, 1, firstVertex + 1);
-                m_animator.registerVertex(tri.proxyId, m_mesh, 2, firstVertex + 2);
             }
             for( const Triangle& tri : mesh.colored_triangles )
             {
@@ -191,12 +204,13 @@ namespace loader
                 for( int i = 0; i < 3; ++i )
                 {
                     RenderVertex iv;
+                    iv.boneIndex = boneIndex;
                     iv.position = mesh.vertices[tri.vertices[i]].toRenderSystem();
                     if(tri.vertices[i] < mesh.vertexDarknesses.size())
                         iv.color = glm::vec4(1 - mesh.vertexDarknesses[tri.vertices[i]] / 8192.0f);
                     else
                         iv.color = glm::vec4(1.0f);
-                    iv.uv = proxy.uvCoordinates[i].toGl();
+                    iv.uv = getUv(proxy, i);
                     m_parts[partId].indices.emplace_back(m_vertexCount);
                     append(iv);
                 }
@@ -213,16 +227,17 @@ namespace loader
                 for( int i = 0; i < 4; ++i )
                 {
                     RenderVertexWithNormal iv;
+                    iv.boneIndex = boneIndex;
                     iv.position = mesh.vertices[quad.vertices[i]].toRenderSystem();
                     iv.normal = mesh.normals[quad.vertices[i]].toRenderSystem();
                     iv.color = glm::vec4(1.0f);
-                    iv.uv = proxy.uvCoordinates[i].toGl();
+                    iv.uv = getUv(proxy, i);
+                    iv.textureAnimation = m_animator.getVertexAttribute(quad.proxyId, i);
                     append(iv);
                 }
 
                 for(auto j : { 0,1,2,0,2,3 })
                 {
-                    m_animator.registerVertex(quad.proxyId, m_mesh, j, firstVertex + j);
                     m_parts[partId].indices.emplace_back(firstVertex + j);
                 }
             }
@@ -235,10 +250,11 @@ namespace loader
                 for( int i = 0; i < 4; ++i )
                 {
                     RenderVertexWithNormal iv;
+                    iv.boneIndex = boneIndex;
                     iv.position = mesh.vertices[quad.vertices[i]].toRenderSystem();
                     iv.normal = mesh.normals[quad.vertices[i]].toRenderSystem();
                     iv.color = glm::vec4(1.0f);
-                    iv.uv = proxy.uvCoordinates[i].toGl();
+                    iv.uv = getUv(proxy, i);
                     append(iv);
                 }
                 for(auto j : { 0,1,2,0,2,3 })
@@ -251,21 +267,18 @@ namespace loader
                 const TextureLayoutProxy& proxy = m_textureProxies.at(tri.proxyId);
                 const auto partId = getPartForTexture(proxy);
 
-                const auto firstVertex = m_vertexCount;
                 for( int i = 0; i < 3; ++i )
                 {
                     RenderVertexWithNormal iv;
+                    iv.boneIndex = boneIndex;
                     iv.position = mesh.vertices[tri.vertices[i]].toRenderSystem();
                     iv.normal = mesh.normals[tri.vertices[i]].toRenderSystem();
                     iv.color = glm::vec4(1.0f);
-                    iv.uv = proxy.uvCoordinates[i].toGl();
+                    iv.uv = getUv(proxy, i);
+                    iv.textureAnimation = m_animator.getVertexAttribute(tri.proxyId, i);
                     m_parts[partId].indices.emplace_back(m_vertexCount);
                     append(iv);
                 }
-
-                m_animator.registerVertex(tri.proxyId, m_mesh, 0, firstVertex + 0);
-                m_animator.registerVertex(tri.proxyId, m_mesh, 1, firstVertex + 1);
-                m_animator.registerVertex(tri.proxyId, m_mesh, 2, firstVertex + 2);
             }
             for( const Triangle& tri : mesh.colored_triangles )
             {
@@ -275,10 +288,11 @@ namespace loader
                 for( int i = 0; i < 3; ++i )
                 {
                     RenderVertexWithNormal iv;
+                    iv.boneIndex = boneIndex;
                     iv.position = mesh.vertices[tri.vertices[i]].toRenderSystem();
                     iv.normal = mesh.normals[tri.vertices[i]].toRenderSystem();
                     iv.color = glm::vec4(1.0f);
-                    iv.uv = proxy.uvCoordinates[i].toGl();
+                    iv.uv = getUv(proxy, i);
                     m_parts[partId].indices.emplace_back(m_vertexCount);
                     append(iv);
                 }
@@ -323,9 +337,10 @@ namespace loader
 
     std::shared_ptr<gameplay::Model> Mesh::createModel(const std::vector<TextureLayoutProxy>& textureProxies,
                                                        const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& materials,
+                                                       uint16_t textureIndexMask,
                                                        const std::shared_ptr<gameplay::Material>& colorMaterial,
                                                        const Palette& palette,
-                                                       render::TextureAnimator& animator,
+                                                       const render::TextureAnimator& animator,
                                                        const std::string& label) const
     {
         ModelBuilder mb{
@@ -333,6 +348,7 @@ namespace loader
             false,
             textureProxies,
             materials,
+            textureIndexMask,
             colorMaterial,
             palette,
             animator,
@@ -96,10 +96,13 @@ namespace loader
             std::vector<float> m_vbuf;
             const std::vector<TextureLayoutProxy>& m_textureProxies;
             const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& m_materials;
+            const uint16_t m_textureIndexMask;
             const std::shared_ptr<gameplay::Material> m_colorMaterial;
             const Palette& m_palette;
-            render::TextureAnimator& m_animator;
+            const render::TextureAnimator& m_animator;
             std::map<TextureLayoutProxy::TextureKey, size_t> m_texBuffers;
+            //! Textured faces are grouped by material, as all texture pages are layers of the same texture
+            std::map<std::shared_ptr<gameplay::Material>, size_t> m_materialParts;
             size_t m_vertexCount = 0;
             std::shared_ptr<gameplay::Mesh> m_mesh;
 
@@ -144,15 +147,22 @@ namespace loader
 
             size_t getPartForTexture(const TextureLayoutProxy& proxy)
             {
-                if( m_texBuffers.find(proxy.textureKey) == m_texBuffers.end() )
+                auto it = m_materials.find(proxy.textureKey);
+                Expects(it != m_materials.end());
+
+                if( m_materialParts.find(it->second) == m_materialParts.end() )
                 {
-                    m_texBuffers[proxy.textureKey] = m_parts.size();
+                    m_materialParts[it->second] = m_parts.size();
                     m_parts.emplace_back();
-                    auto it = m_materials.find(proxy.textureKey);
-                    Expects(it != m_materials.end());
                     m_parts.back().material = it->second;
                 }
-                return m_texBuffers[proxy.textureKey];
+                return m_materialParts[it->second];
+            }
+
+
+            glm::vec3 getUv(const TextureLayoutProxy& proxy, int corner) const
+            {
+                return glm::vec3{proxy.uvCoordinates[corner].toGl(), static_cast<float>(proxy.textureKey.tileAndFlag & m_textureIndexMask)};
             }
 
 
@@ -161,14 +171,19 @@ namespace loader
                                   bool dynamic,
                                   const std::vector<TextureLayoutProxy>& textureProxies,
                                   const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& materials,
+                                  uint16_t textureIndexMask,
                                   const std::shared_ptr<gameplay::Material>& colorMaterial,
                                   const Palette& palette,
-                                  render::TextureAnimator& animator,
+                                  const render::TextureAnimator& animator,
                                   const std::string& label = {});
             ~ModelBuilder();
 
 
-            void append(const Mesh& mesh);
+            /**
+             * @param[in] mesh The mesh to append.
+             * @param[in] boneIndex Index into the bone palette of a skinned model; ignored by non-skinned materials.
+             */
+            void append(const Mesh& mesh, float boneIndex = 0);
 
             std::shared_ptr<gameplay::Model> finalize();
         };
@@ -176,8 +191,9 @@ namespace loader
 
         std::shared_ptr<gameplay::Model> createModel(const std::vector<TextureLayoutProxy>& textureProxies,
                                                      const std::map<TextureLayoutProxy::TextureKey, std::shared_ptr<gameplay::Material>>& materials,
+                                                     uint16_t textureIndexMask,
                                                      const std::shared_ptr<gameplay::Material>& colorMaterial,
-                                                     const Palette& palette, render::TextureAnimator& animator,
+                                                     const Palette& palette, const render::TextureAnimator& animator,
                                                      const std::string& label = {}) const;
     };
 }
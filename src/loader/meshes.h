@@ -126,6 +126,9 @@ namespace loader
 
         gameplay::BoundingBox getCollisionBox(const core::TRCoordinates& pos, core::Angle angle) const;
 
+        //! The box enclosing the mesh at the given placement, in world coordinates
+        gameplay::BoundingBox getVisibilityBox(const core::TRCoordinates& pos, core::Angle angle) const;
+
 
         static std::unique_ptr<StaticMesh> read(io::SDLReader& reader)
         {
@@ -1,7 +1,8 @@
 #include "texture.h"
 
-#include "engine/items/itemnode.h"
 #include "loader/trx/trx.h"
+#include "render/itemlighting.h"
+#include "util/threadpool.h"
 
 #include <glm/gtc/type_ptr.hpp>
 
@@ -23,11 +24,8 @@ std::shared_ptr<gameplay::Material> createMaterial(const std::shared_ptr<gamepla
     texture->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     texture->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     result->getParameter("u_diffuseTexture")->set(texture);
-    result->getParameter("u_worldViewProjectionMatrix")->bindWorldViewProjectionMatrix();
     result->getParameter("u_modelMatrix")->bindModelMatrix();
-    result->getParameter("u_baseLight")->bind(&engine::items::ItemNode::lightBaseBinder);
-    result->getParameter("u_baseLightDiff")->bind(&engine::items::ItemNode::lightBaseDiffBinder);
-    result->getParameter("u_lightPosition")->bind(&engine::items::ItemNode::lightPositionBinder);
+    render::ItemLighting::bindDefaults(*result);
     result->initStateBlockDefaults();
 
     switch( bmode )
@@ -49,114 +47,133 @@ std::shared_ptr<gameplay::Material> createMaterial(const std::shared_ptr<gamepla
 }
 
 
-std::shared_ptr<gameplay::ext::Image<gameplay::gl::RGBA8>> DWordTexture::toImage(trx::Glidos* glidos, const boost::filesystem::path& lvlName) const
+namespace
 {
-    if( glidos == nullptr )
-    {
-        return std::make_shared<gameplay::ext::Image<gameplay::gl::RGBA8>>(256, 256, &pixels[0][0]);
-    }
+constexpr int Resolution = 2048;
+constexpr int Scale = Resolution / 256;
 
-    BOOST_LOG_TRIVIAL(info) << "Upgrading texture " << md5 << "...";
+using Image = gameplay::ext::Image<gameplay::gl::RGBA8>;
 
-    constexpr int Resolution = 2048;
-    constexpr int Scale = Resolution / 256;
 
-    auto mapping = glidos->getMappingsForTexture(md5);
-    const auto cacheName = mapping.baseDir / "_edisonengine" / lvlName / (md5 + ".png");
+cimg_library::CImg<uint8_t> loadRgba(const boost::filesystem::path& path, uint8_t defaultAlpha)
+{
+    cimg_library::CImg<uint8_t> image(path.string().c_str());
 
-    if( is_regular_file(cacheName) &&
-        std::chrono::system_clock::from_time_t(last_write_time(cacheName)) > mapping.newestSource )
+    if( image.spectrum() == 3 )
     {
-        BOOST_LOG_TRIVIAL(info) << "Loading cached texture " << cacheName << "...";
-        cimg_library::CImg<uint8_t> cacheImage(cacheName.string().c_str());
+        image.channels(0, 3);
+        BOOST_ASSERT(image.spectrum() == 4);
+        image.get_shared_channel(3).fill(defaultAlpha);
+    }
 
-        if( cacheImage.spectrum() == 3 )
-        {
-            cacheImage.channels(0, 3);
-            BOOST_ASSERT(cacheImage.spectrum() == 4);
-            cacheImage.get_shared_channel(3).fill(1);
-        }
+    if( image.spectrum() != 4 )
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Can only use RGB and RGBA images"));
+    }
 
-        if( cacheImage.spectrum() != 4 )
-        {
-            BOOST_THROW_EXCEPTION(std::runtime_error("Can only use RGB and RGBA images"));
-        }
+    return image;
+}
 
-        const auto w = cacheImage.width();
-        const auto h = cacheImage.height();
 
-        // interleave
-        cacheImage.permute_axes("cxyz");
+std::shared_ptr<Image> toInterleavedImage(cimg_library::CImg<uint8_t>& image)
+{
+    const auto w = image.width();
+    const auto h = image.height();
 
-        return std::make_shared<gameplay::ext::Image<gameplay::gl::RGBA8>>(w, h, reinterpret_cast<const gameplay::gl::RGBA8*>(cacheImage.data()));
-    }
+    // interleave
+    image.permute_axes("cxyz");
 
-    cimg_library::CImg<uint8_t> original(&pixels[0][0].r, 4, 256, 256, 1, false);
-    // un-interleave
-    original.permute_axes("yzcx");
-    BOOST_ASSERT(original.width() == 256 && original.height() == 256 && original.spectrum() == 4);
-    original.resize(Resolution, Resolution, 1, 4, 6);
-    original.min(uint8_t(255)).max(uint8_t(0)); // interpolation may produce values outside the range 0..255
-    BOOST_ASSERT(original.width() == Resolution && original.height() == Resolution && original.spectrum() == 4);
+    return std::make_shared<Image>(w, h, reinterpret_cast<const gameplay::gl::RGBA8*>(image.data()));
+}
+}
 
-    for( const auto& tile : mapping.tiles )
+
+std::shared_ptr<Image> DWordTexture::toImage() const
+{
+    return std::make_shared<Image>(256, 256, &pixels[0][0]);
+}
+
+
+std::future<std::shared_ptr<Image>> DWordTexture::toImage(trx::Glidos* glidos, const boost::filesystem::path& lvlName, util::ThreadPool& pool) const
+{
+    if( glidos == nullptr )
     {
-        BOOST_LOG_TRIVIAL(info) << "  - Loading " << tile.second << " into " << tile.first;
-        if( !is_regular_file(tile.second) )
-        {
-            BOOST_LOG_TRIVIAL(warning) << "    File not found";
-            continue;
-        }
-
-        cimg_library::CImg<uint8_t> srcImage(tile.second.string().c_str());
-
-        if( srcImage.spectrum() == 3 )
-        {
-            srcImage.channels(0, 3);
-            BOOST_ASSERT(srcImage.spectrum() == 4);
-            srcImage.get_shared_channel(3).fill(255);
-        }
-
-        if( srcImage.spectrum() != 4 )
-        {
-            BOOST_THROW_EXCEPTION(std::runtime_error("Can only use RGB and RGBA images"));
-        }
-
-        srcImage.resize(tile.first.getWidth() * Scale, tile.first.getHeight() * Scale, 1, 4, 6);
-        const auto x0 = tile.first.getX0() * Scale;
-        const auto y0 = tile.first.getY0() * Scale;
-        for( int x = 0; x < srcImage.width(); ++x )
-        {
-            for( int y = 0; y < srcImage.height(); ++y )
-            {
-                BOOST_ASSERT(x + x0 < original.width());
-                BOOST_ASSERT(y + y0 < original.height());
-
-                for( int c = 0; c < 4; ++c )
-                {
-                    const auto pixel = srcImage(x, y, 0, c);
-                    original(x + x0, y + y0, 0, c) = pixel;
-                }
-            }
-        }
+        std::promise<std::shared_ptr<Image>> result;
+        result.set_value(toImage());
+        return result.get_future();
     }
 
-    BOOST_LOG_TRIVIAL(info) << "Writing texture cache " << cacheName << "...";
-    create_directories(cacheName.parent_path());
-    original.save_png(cacheName.string().c_str(), 1);
+    auto mapping = glidos->getMappingsForTexture(md5);
+    const auto cacheName = mapping.baseDir / "_edisonengine" / lvlName / (md5 + ".png");
 
-    // interleave
-    original.permute_axes("cxyz");
+    if( is_regular_file(cacheName) &&
+        std::chrono::system_clock::from_time_t(last_write_time(cacheName)) > mapping.newestSource )
+    {
+        return pool.enqueue([cacheName]()
+                            {
+                                BOOST_LOG_TRIVIAL(info) << "Loading cached texture " << cacheName << "...";
+                                auto cacheImage = loadRgba(cacheName, 1);
+                                return toInterleavedImage(cacheImage);
+                            });
+    }
 
-    return std::make_shared<gameplay::ext::Image<gameplay::gl::RGBA8>>(Resolution, Resolution, reinterpret_cast<const gameplay::gl::RGBA8*>(original.data()));
-}
+    BOOST_LOG_TRIVIAL(info) << "Upgrading texture " << md5 << " with " << mapping.tiles.size() << " tiles...";
 
+    // Every tile is loaded and resized in its own job. They are enqueued before the page job waiting
+    // for them, so they're already running when it does.
+    std::vector<std::pair<trx::Rectangle, std::future<cimg_library::CImg<uint8_t>>>> tiles;
+    tiles.reserve(mapping.tiles.size());
+    for( const auto& tile : mapping.tiles )
+    {
+        tiles.emplace_back(tile.first, pool.enqueue([tile]()
+                                                    {
+                                                        BOOST_LOG_TRIVIAL(debug) << "  - Loading " << tile.second << " into " << tile.first;
+                                                        if( !is_regular_file(tile.second) )
+                                                        {
+                                                            BOOST_LOG_TRIVIAL(warning) << "File not found: " << tile.second;
+                                                            return cimg_library::CImg<uint8_t>{};
+                                                        }
+
+                                                        auto srcImage = loadRgba(tile.second, 255);
+                                                        srcImage.resize(tile.first.getWidth() * Scale, tile.first.getHeight() * Scale, 1, 4, 6);
+                                                        return srcImage;
+                                                    }));
+    }
 
-std::shared_ptr<gameplay::gl::Texture> DWordTexture::toTexture(trx::Glidos* glidos, const boost::filesystem::path& lvlName) const
-{
-    auto texture = std::make_shared<gameplay::gl::Texture>(GL_TEXTURE_2D);
-    auto img = toImage(glidos, lvlName);
-    texture->image2D(img->getWidth(), img->getHeight(), img->getData(), true);
-    return texture;
+    return pool.enqueue([this, cacheName, tiles = std::move(tiles)]() mutable
+                        {
+                            const auto startTime = std::chrono::high_resolution_clock::now();
+
+                            cimg_library::CImg<uint8_t> original(&pixels[0][0].r, 4, 256, 256, 1, false);
+                            // un-interleave
+                            original.permute_axes("yzcx");
+                            BOOST_ASSERT(original.width() == 256 && original.height() == 256 && original.spectrum() == 4);
+                            original.resize(Resolution, Resolution, 1, 4, 6);
+                            original.min(uint8_t(255)).max(uint8_t(0)); // interpolation may produce values outside the range 0..255
+                            BOOST_ASSERT(original.width() == Resolution && original.height() == Resolution && original.spectrum() == 4);
+
+                            for( auto& tile : tiles )
+                            {
+                                const auto srcImage = tile.second.get();
+                                if( srcImage.is_empty() )
+                                    continue;
+
+                                const auto x0 = tile.first.getX0() * Scale;
+                                const auto y0 = tile.first.getY0() * Scale;
+                                BOOST_ASSERT(x0 + srcImage.width() <= original.width());
+                                BOOST_ASSERT(y0 + srcImage.height() <= original.height());
+
+                                original.draw_image(x0, y0, 0, 0, srcImage);
+                            }
+
+                            BOOST_LOG_TRIVIAL(info) << "Writing texture cache " << cacheName << "...";
+                            create_directories(cacheName.parent_path());
+                            original.save_png(cacheName.string().c_str(), 1);
+
+                            const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - startTime);
+                            BOOST_LOG_TRIVIAL(info) << "Upgraded texture " << md5 << " in " << duration.count() << "ms";
+
+                            return toInterleavedImage(original);
+                        });
 }
 }
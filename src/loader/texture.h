@@ -6,6 +6,14 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <future>
+
+
+namespace util
+{
+class ThreadPool;
+}
+
 
 namespace loader
 {
@@ -87,9 +95,16 @@ struct DWordTexture final
     }
 
 
-    std::shared_ptr<gameplay::gl::Texture> toTexture(trx::Glidos* glidos, const boost::filesystem::path& lvlName) const;
+    std::shared_ptr<gameplay::ext::Image<gameplay::gl::RGBA8>> toImage() const;
 
-    std::shared_ptr<gameplay::ext::Image<gameplay::gl::RGBA8>> toImage(trx::Glidos* glidos, const boost::filesystem::path& lvlName) const;
+    /**
+     * @brief Creates the image of this texture, upgraded with the tiles of a Glidos pack if one is given.
+     *
+     * Loading, resizing and caching the upgraded image happens on @a pool; the texture must outlive
+     * the returned future.
+     */
+    std::future<std::shared_ptr<gameplay::ext::Image<gameplay::gl::RGBA8>>>
+    toImage(trx::Glidos* glidos, const boost::filesystem::path& lvlName, util::ThreadPool& pool) const;
 };
 
 
@@ -7,7 +7,9 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 
+#include <fstream>
 #include <regex>
+#include <unordered_map>
 
 
 namespace loader
@@ -23,7 +25,8 @@ namespace loader
             explicit Rectangle(const std::string& serialized)
             {
                 // Format: (x0--x1)(y0--y1)
-                std::regex fmt("\\(([0-9]+)--([0-9]+)\\)\\(([0-9]+)--([0-9]+)\\).*");
+                // compiling the expression is far more expensive than matching it, and packs have many thousands of tiles
+                static const std::regex fmt("\\(([0-9]+)--([0-9]+)\\)\\(([0-9]+)--([0-9]+)\\).*");
                 std::smatch matches;
                 if( !std::regex_match(serialized, matches, fmt) )
                 {
@@ -45,6 +48,17 @@ namespace loader
             }
 
 
+            explicit Rectangle(uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1)
+                : m_x0{x0}
+                , m_x1{x1}
+                , m_y0{y0}
+                , m_y1{y1}
+            {
+                BOOST_ASSERT(m_x0 <= m_x1);
+                BOOST_ASSERT(m_y0 <= m_y1);
+            }
+
+
             bool operator<(const Rectangle& rhs) const
             {
                 if( m_x0 != rhs.m_x0 )
@@ -263,6 +277,14 @@ namespace loader
                     m_root = m_baseDir / m_root;
                 }
 
+                const auto indexPath = m_baseDir / "_edisonengine" / "glidos.index";
+                const auto directoryTimestamps = getDirectoryTimestamps(pathMap);
+                if( readIndex(indexPath, directoryTimestamps) )
+                {
+                    BOOST_LOG_TRIVIAL(info) << "Loaded Glidos index " << indexPath << " with " << m_index.size() << " textures";
+                    return;
+                }
+
                 Equiv equiv;
                 {
                     std::ifstream txt{(m_baseDir / "equiv.txt").string()};
@@ -321,6 +343,9 @@ namespace loader
                 }
 
                 resolveEquiv(equiv);
+                buildIndex();
+                writeIndex(indexPath, directoryTimestamps);
+                m_sourceTimestamps.clear();
             }
 
 
@@ -328,9 +353,9 @@ namespace loader
             {
                 BOOST_LOG_TRIVIAL(info) << "Glidos database dump";
                 std::set<std::string> md5s;
-                for( const auto& part : m_links )
+                for( const auto& entry : m_index )
                 {
-                    md5s.insert(part.first.getId());
+                    md5s.insert(entry.first);
                 }
 
                 for( const auto& md5 : md5s )
@@ -361,18 +386,13 @@ namespace loader
 
             TileMap getMappingsForTexture(const std::string& textureId) const
             {
+                const auto it = m_index.find(textureId);
+                if( it != m_index.end() )
+                    return it->second;
+
                 TileMap result;
-                result.newestSource = std::max(m_newestTextureSourceTimestamps[textureId], m_rootTimestamp);
+                result.newestSource = m_rootTimestamp;
                 result.baseDir = m_baseDir;
-
-                for( const auto& link : m_links )
-                {
-                    if( link.first.getId() != textureId )
-                        continue;
-
-                    result.tiles[link.first.getRectangle()] = link.second;
-                }
-
                 return result;
             }
 
@@ -502,7 +522,270 @@ namespace loader
             }
 
 
-            boost::filesystem::path readSymlink(const boost::filesystem::path& ref, std::chrono::system_clock::time_point& srcTimestamp) const
+            //! Last write time of a file or directory, or -1 if it doesn't exist
+            static int64_t getTimestamp(const boost::filesystem::path& path)
+            {
+                boost::system::error_code ec;
+                const auto timestamp = boost::filesystem::last_write_time(path, ec);
+                return ec ? -1 : int64_t(timestamp);
+            }
+
+
+            //! Last write time of every texture directory of the pack, or -1 if it doesn't exist
+            std::vector<std::pair<std::string, int64_t>> getDirectoryTimestamps(const PathMap& pathMap) const
+            {
+                std::vector<std::pair<std::string, int64_t>> result;
+                for( const auto& texturePath : pathMap.getMap() )
+                    result.emplace_back(texturePath.first, getTimestamp(m_root / texturePath.second));
+                return result;
+            }
+
+
+            //! Groups the resolved links by texture, so that lookups don't need to scan all links
+            void buildIndex()
+            {
+                m_index.clear();
+
+                for( const auto& timestamp : m_newestTextureSourceTimestamps )
+                {
+                    auto& entry = m_index[timestamp.first];
+                    entry.newestSource = std::max(timestamp.second, m_rootTimestamp);
+                    entry.baseDir = m_baseDir;
+                }
+
+                for( const auto& link : m_links )
+                {
+                    auto it = m_index.find(link.first.getId());
+                    if( it == m_index.end() )
+                    {
+                        it = m_index.emplace(link.first.getId(), TileMap{}).first;
+                        it->second.newestSource = m_rootTimestamp;
+                        it->second.baseDir = m_baseDir;
+                    }
+
+                    it->second.tiles[link.first.getRectangle()] = link.second;
+
+                    // the tile images are sources of the upgraded textures, too
+                    auto source = m_sourceTimestamps.find(link.second.string());
+                    if( source == m_sourceTimestamps.end() )
+                        source = m_sourceTimestamps.emplace(link.second.string(), getTimestamp(link.second)).first;
+                    if( source->second >= 0 )
+                        it->second.newestSource = std::max(it->second.newestSource, std::chrono::system_clock::from_time_t(std::time_t(source->second)));
+                }
+
+                // the links are only needed while resolving the pack
+                m_links.clear();
+                m_newestTextureSourceTimestamps.clear();
+            }
+
+
+            /*
+             * Index file layout, all integers in native byte order:
+             *   "EEGI", u32 version, i64 root timestamp
+             *   u32 directory count, {string md5, i64 timestamp}...
+             *   u32 source count, {string path, i64 timestamp}...
+             *   u32 texture count, {string md5, i64 newest source, u32 tile count, {u32 x0, x1, y0, y1, string path}...}...
+             * Strings are stored as u32 length followed by the characters.
+             *
+             * The index is stale if the mapping or equiv file, the contents of any texture directory, or any of the
+             * link files and tile images the textures were resolved from change.  Entries which are out of range
+             * are treated as corruption, and the index is rebuilt.
+             */
+            static constexpr uint32_t IndexVersion = 2;
+
+            //! The size of the texture pages the tiles are placed on
+            static constexpr uint32_t PageSize = 256;
+
+
+            template<typename T>
+            static void writeValue(std::ostream& stream, const T& value)
+            {
+                stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+            }
+
+
+            static void writeString(std::ostream& stream, const std::string& value)
+            {
+                writeValue(stream, gsl::narrow<uint32_t>(value.size()));
+                stream.write(value.data(), value.size());
+            }
+
+
+            template<typename T>
+            static T readValue(std::istream& stream)
+            {
+                T value{};
+                stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+                return value;
+            }
+
+
+            static std::string readString(std::istream& stream)
+            {
+                const auto size = readValue<uint32_t>(stream);
+                if( !stream || size > 4096 )
+                {
+                    stream.setstate(std::ios::failbit);
+                    return {};
+                }
+
+                std::string value(size, '\0');
+                stream.read(&value[0], size);
+                return value;
+            }
+
+
+            void writeIndex(const boost::filesystem::path& indexPath, const std::vector<std::pair<std::string, int64_t>>& directoryTimestamps) const
+            {
+                boost::system::error_code ec;
+                boost::filesystem::create_directories(indexPath.parent_path(), ec);
+
+                const auto tmpPath = boost::filesystem::path(indexPath).concat(".tmp");
+                {
+                    std::ofstream stream{tmpPath.string(), std::ios::binary | std::ios::trunc};
+                    if( !stream.is_open() )
+                    {
+                        BOOST_LOG_TRIVIAL(warning) << "Failed to create Glidos index " << indexPath;
+                        return;
+                    }
+
+                    stream.write("EEGI", 4);
+                    writeValue(stream, uint32_t{IndexVersion});
+                    writeValue(stream, int64_t(std::chrono::system_clock::to_time_t(m_rootTimestamp)));
+
+                    writeValue(stream, gsl::narrow<uint32_t>(directoryTimestamps.size()));
+                    for( const auto& directory : directoryTimestamps )
+                    {
+                        writeString(stream, directory.first);
+                        writeValue(stream, directory.second);
+                    }
+
+                    writeValue(stream, gsl::narrow<uint32_t>(m_sourceTimestamps.size()));
+                    for( const auto& source : m_sourceTimestamps )
+                    {
+                        writeString(stream, source.first);
+                        writeValue(stream, source.second);
+                    }
+
+                    writeValue(stream, gsl::narrow<uint32_t>(m_index.size()));
+                    for( const auto& entry : m_index )
+                    {
+                        writeString(stream, entry.first);
+                        writeValue(stream, int64_t(std::chrono::system_clock::to_time_t(entry.second.newestSource)));
+                        writeValue(stream, gsl::narrow<uint32_t>(entry.second.tiles.size()));
+                        for( const auto& tile : entry.second.tiles )
+                        {
+                            writeValue(stream, tile.first.getX0());
+                            writeValue(stream, tile.first.getX1());
+                            writeValue(stream, tile.first.getY0());
+                            writeValue(stream, tile.first.getY1());
+                            writeString(stream, tile.second.string());
+                        }
+                    }
+
+                    if( !stream )
+                    {
+                        BOOST_LOG_TRIVIAL(warning) << "Failed to write Glidos index " << indexPath;
+                        return;
+                    }
+                }
+
+                boost::filesystem::rename(tmpPath, indexPath, ec);
+                if( ec )
+                    BOOST_LOG_TRIVIAL(warning) << "Failed to write Glidos index " << indexPath << ": " << ec.message();
+            }
+
+
+            bool readIndex(const boost::filesystem::path& indexPath, const std::vector<std::pair<std::string, int64_t>>& directoryTimestamps)
+            {
+                std::ifstream stream{indexPath.string(), std::ios::binary};
+                if( !stream.is_open() )
+                    return false;
+
+                char magic[4];
+                stream.read(magic, 4);
+                if( !stream || std::string(magic, 4) != "EEGI" || readValue<uint32_t>(stream) != IndexVersion
+                    || readValue<int64_t>(stream) != int64_t(std::chrono::system_clock::to_time_t(m_rootTimestamp)) )
+                {
+                    BOOST_LOG_TRIVIAL(info) << "Glidos index " << indexPath << " is stale";
+                    return false;
+                }
+
+                const auto directoryCount = readValue<uint32_t>(stream);
+                if( !stream || directoryCount != directoryTimestamps.size() )
+                {
+                    BOOST_LOG_TRIVIAL(info) << "Glidos index " << indexPath << " is stale";
+                    return false;
+                }
+                for( const auto& directory : directoryTimestamps )
+                {
+                    const auto md5 = readString(stream);
+                    const auto timestamp = readValue<int64_t>(stream);
+                    if( !stream || md5 != directory.first || timestamp != directory.second )
+                    {
+                        BOOST_LOG_TRIVIAL(info) << "Glidos index " << indexPath << " is stale";
+                        return false;
+                    }
+                }
+
+                const auto sourceCount = readValue<uint32_t>(stream);
+                for( uint32_t i = 0; stream && i < sourceCount; ++i )
+                {
+                    const auto path = readString(stream);
+                    const auto timestamp = readValue<int64_t>(stream);
+                    if( stream && getTimestamp(path) != timestamp )
+                    {
+                        BOOST_LOG_TRIVIAL(info) << "Glidos index " << indexPath << " is stale";
+                        return false;
+                    }
+                }
+
+                std::unordered_map<std::string, TileMap> index;
+                const auto textureCount = readValue<uint32_t>(stream);
+                for( uint32_t i = 0; stream && i < textureCount; ++i )
+                {
+                    const auto md5 = readString(stream);
+                    const auto newestSource = readValue<int64_t>(stream);
+                    if( !stream || md5.size() != 32 || newestSource < 0 )
+                    {
+                        stream.setstate(std::ios::failbit);
+                        break;
+                    }
+
+                    auto& entry = index[md5];
+                    entry.newestSource = std::chrono::system_clock::from_time_t(std::time_t(newestSource));
+                    entry.baseDir = m_baseDir;
+
+                    const auto tileCount = readValue<uint32_t>(stream);
+                    for( uint32_t j = 0; stream && j < tileCount; ++j )
+                    {
+                        const auto x0 = readValue<uint32_t>(stream);
+                        const auto x1 = readValue<uint32_t>(stream);
+                        const auto y0 = readValue<uint32_t>(stream);
+                        const auto y1 = readValue<uint32_t>(stream);
+                        const auto path = readString(stream);
+                        if( !stream || x0 > x1 || y0 > y1 || x1 > PageSize || y1 > PageSize || path.empty() )
+                        {
+                            stream.setstate(std::ios::failbit);
+                            break;
+                        }
+
+                        entry.tiles[Rectangle{x0, x1, y0, y1}] = path;
+                    }
+                }
+
+                if( !stream )
+                {
+                    BOOST_LOG_TRIVIAL(warning) << "Glidos index " << indexPath << " is corrupt";
+                    return false;
+                }
+
+                m_index = std::move(index);
+                return true;
+            }
+
+
+            boost::filesystem::path readSymlink(const boost::filesystem::path& ref, std::chrono::system_clock::time_point& srcTimestamp)
             {
                 if(ref.extension() != ".txt")
                     return ref;
@@ -522,7 +805,9 @@ namespace loader
                     head.erase(0, head.find(":") + 1);
                     boost::algorithm::trim(head);
                     boost::algorithm::replace_all(head, "\\", "/");
-                    srcTimestamp = std::max(srcTimestamp, std::chrono::system_clock::from_time_t(boost::filesystem::last_write_time(ref)));
+                    const auto timestamp = boost::filesystem::last_write_time(ref);
+                    m_sourceTimestamps[ref.string()] = int64_t(timestamp);
+                    srcTimestamp = std::max(srcTimestamp, std::chrono::system_clock::from_time_t(timestamp));
                     return readSymlink(m_root / head, srcTimestamp);
                 }
                 else
@@ -535,7 +820,11 @@ namespace loader
             boost::filesystem::path m_root;
             boost::filesystem::path m_baseDir;
             mutable std::map<std::string, std::chrono::system_clock::time_point> m_newestTextureSourceTimestamps;
+            //! Last write time of every link file and tile image followed while resolving the pack, for validating the index
+            std::map<std::string, int64_t> m_sourceTimestamps;
             std::chrono::system_clock::time_point m_rootTimestamp;
+            //! Tiles and newest source timestamp for every texture of the pack, by MD5
+            std::unordered_map<std::string, TileMap> m_index;
         };
     }
 }
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "gameplay.h"
+
+
+namespace render
+{
+    //! The number of item and static mesh nodes tested for visibility in the current frame
+    struct CullingStatistics
+    {
+        size_t drawn = 0;
+        size_t culled = 0;
+    };
+
+
+    /**
+     * @brief Tests if a box in world space may be visible through a rectangle of the screen.
+     *
+     * @param box The box to test, in render system coordinates.
+     * @param screenRect The rectangle the box must overlap, in normalized device coordinates,
+     *                   as built by PortalTracer.
+     * @param camera The camera the scene is drawn with.
+     */
+    inline bool isVisible(const gameplay::BoundingBox& box, const gameplay::BoundingBox& screenRect, const gameplay::Camera& camera)
+    {
+        if( !camera.getFrustum().intersects(box) )
+            return false;
+
+        glm::vec3 corners[8];
+        box.getCorners(corners);
+
+        glm::vec2 min{1, 1};
+        glm::vec2 max{-1, -1};
+        for( const auto& corner : corners )
+        {
+            const auto projected = camera.getViewProjectionMatrix() * glm::vec4{corner, 1};
+            if( projected.w <= camera.getNearPlane() )
+                return true; // the box reaches behind the camera, so its projection is unbounded
+
+            const glm::vec2 screen{projected.x / projected.w, projected.y / projected.w};
+            min = glm::min(min, screen);
+            max = glm::max(max, screen);
+        }
+
+        return min.x <= screenRect.max.x && max.x >= screenRect.min.x
+               && min.y <= screenRect.max.y && max.y >= screenRect.min.y;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "gameplay.h"
+#include "gl/uniformbuffer.h"
+
+#include <chrono>
+
+
+namespace render
+{
+    /**
+     * @brief The data shared by all programs in a frame, uploaded once into the "Frame" uniform block.
+     *
+     * The layout must match shaders/frame.glsl.  Binding it once per frame leaves only the model
+     * matrix and the material specific data to be set per draw call.
+     */
+    class FrameUniforms
+    {
+        // std140 layout; all members are aligned to 16 bytes, except the scalars at the end
+        struct Data
+        {
+            glm::mat4 view{1.0f};
+            glm::mat4 projection{1.0f};
+            glm::mat4 viewProjection{1.0f};
+            glm::vec4 cameraPosition{0.0f};
+            GLfloat time = 0;
+            GLint inWater = 0;
+            GLfloat padding[2] = {0, 0};
+        };
+
+
+        static_assert(sizeof(Data) == 3 * sizeof(glm::mat4) + sizeof(glm::vec4) + 4 * sizeof(GLfloat), "Invalid frame uniform layout");
+
+        Data m_data;
+        gameplay::gl::UniformBuffer m_buffer{"frame uniforms"};
+
+    public:
+        void update(const gameplay::Camera& camera, const std::chrono::high_resolution_clock::time_point& time, bool inWater)
+        {
+            m_data.view = camera.getViewMatrix();
+            m_data.projection = camera.getProjectionMatrix();
+            m_data.viewProjection = camera.getViewProjectionMatrix();
+            m_data.cameraPosition = glm::vec4{glm::vec3{camera.getInverseViewMatrix()[3]}, 1};
+            const auto ms = std::chrono::time_point_cast<std::chrono::milliseconds>(time);
+            m_data.time = gsl::narrow_cast<float>(ms.time_since_epoch().count());
+            m_data.inWater = inWater ? 1 : 0;
+
+            m_buffer.setData(m_data);
+            m_buffer.bindBase(UNIFORM_BLOCK_FRAME_BINDING);
+        }
+    };
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "gameplay.h"
+
+#include <boost/assert.hpp>
+
+#include <gsl/gsl>
+
+#include <vector>
+
+
+namespace render
+{
+    /**
+     * @brief Draws its model once per instance with a single draw call per mesh part.
+     *
+     * The instances are placed relative to the node and may only be rotated around the Y axis, as the
+     * room static meshes are.  Their transforms and brightness are uploaded as uniform arrays, the
+     * same way the bone palettes of skinned models are, and picked by gl_InstanceID in the shaders.
+     * Apart from their brightness, they are lit like nodes not lit by an item, i.e. without a direction,
+     * see render::ItemLighting.
+     */
+    class InstancedNode : public gameplay::Node
+    {
+    public:
+        //! Must match MaxInstances in the shaders
+        static constexpr size_t MaxInstances = 32;
+
+
+        struct Instance
+        {
+            //! Relative to the node
+            glm::vec3 translation;
+            //! Rotation around the negative Y axis, in radians
+            float rotation;
+            float brightness;
+        };
+
+
+        explicit InstancedNode(const std::string& id,
+                               const std::shared_ptr<gameplay::Drawable>& drawable,
+                               const std::vector<Instance>& instances)
+            : Node{id}
+        {
+            Expects(!instances.empty() && instances.size() <= MaxInstances);
+
+            setDrawable(drawable);
+            setInstanceCount(instances.size());
+
+            for( const Instance& instance : instances )
+            {
+                m_transforms.emplace_back(instance.translation, instance.rotation);
+                m_brightness.emplace_back(instance.brightness);
+            }
+
+            addMaterialParameterSetter("u_instanced", [](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
+            {
+                uniform.set(1);
+            });
+            addMaterialParameterSetter("u_instanceTransforms", [this](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
+            {
+                uniform.set(m_transforms.data(), gsl::narrow<GLsizei>(m_transforms.size()));
+            });
+            addMaterialParameterSetter("u_instanceBrightness", [this](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
+            {
+                uniform.set(m_brightness.data(), gsl::narrow<GLsizei>(m_brightness.size()));
+            });
+        }
+
+
+        //! The transform of an instance relative to the node; must match getInstanceMatrix() in the shaders
+        glm::mat4 getInstanceMatrix(size_t idx) const
+        {
+            BOOST_ASSERT(idx < m_transforms.size());
+            const auto& transform = m_transforms[idx];
+            return glm::translate(glm::mat4{1.0f}, glm::vec3{transform}) * glm::rotate(glm::mat4{1.0f}, transform.w, glm::vec3{0, -1, 0});
+        }
+
+
+        /**
+         * @brief Registers the parameters provided by instanced nodes with a material.
+         *
+         * Node setters only override parameters the material knows of, so all of them need a default,
+         * which also keeps other nodes using the same shaders from being drawn instanced.
+         */
+        static void bindDefaults(gameplay::Material& material)
+        {
+            material.getParameter("u_instanced")->set(0);
+            material.getParameter("u_instanceTransforms")->set(glm::vec4{0.0f});
+            material.getParameter("u_instanceBrightness")->set(0.0f);
+        }
+
+
+    private:
+        //! The translation, and the rotation in w
+        std::vector<glm::vec4> m_transforms;
+        std::vector<float> m_brightness;
+    };
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "gameplay.h"
+#include "gl/uniformbuffer.h"
+
+#include <boost/assert.hpp>
+#include <boost/log/trivial.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+
+namespace render
+{
+    /**
+     * @brief The lighting of all items, uploaded once per frame into the "ItemLighting" uniform block.
+     *
+     * Each item reserves an entry, and selects it for its nodes with a single integer uniform, so that
+     * all bones of an item share the lighting resolved once per item update.  The first entry is used
+     * by nodes not lit by an item.  The layout must match shaders/itemlighting.glsl.
+     */
+    class ItemLighting
+    {
+    public:
+        //! Must match MaxItemLights in the shaders; 32 bytes each fill the minimum block size of 16 KiB
+        static constexpr size_t MaxLights = 512;
+
+
+        // std140 layout; the array stride is rounded up to 16 bytes
+        struct Light
+        {
+            //! NaN if the item is lit without a direction
+            glm::vec3 position{std::numeric_limits<float>::quiet_NaN()};
+            GLfloat base = 1;
+            GLfloat baseDiff = 0;
+            GLfloat padding[3] = {0, 0, 0};
+        };
+
+
+        static_assert(sizeof(Light) == 32, "Invalid item light layout");
+
+
+        //! Reserves an entry for an item, or returns the entry of unlit nodes if all are in use
+        GLint allocate()
+        {
+            // reuse the entries of destroyed items first, e.g. of darts that hit something
+            if( !m_free.empty() )
+            {
+                const auto index = m_free.back();
+                m_free.pop_back();
+                return index;
+            }
+
+            if( m_used >= MaxLights )
+            {
+                BOOST_LOG_TRIVIAL(warning) << "Too many lit items, the remaining ones are drawn unlit";
+                return 0;
+            }
+
+            return gsl::narrow<GLint>(m_used++);
+        }
+
+
+        //! Returns an entry reserved by allocate(), when its item is destroyed
+        void release(GLint index)
+        {
+            Expects(index >= 0 && static_cast<size_t>(index) < m_used);
+
+            if( index == 0 )
+                return;
+
+            BOOST_ASSERT(std::find(m_free.begin(), m_free.end(), index) == m_free.end());
+            m_lights[index] = Light{};
+            m_dirty = true;
+            m_free.emplace_back(index);
+        }
+
+
+        void set(GLint index, const Light& light)
+        {
+            Expects(index >= 0 && static_cast<size_t>(index) < m_used);
+
+            // the entry of unlit nodes is shared, and items falling back to it must not change it
+            if( index == 0 )
+                return;
+
+            m_lights[index] = light;
+            m_dirty = true;
+        }
+
+
+        //! Uploads the entries changed since the last frame, and binds the block for all programs.
+        void update()
+        {
+            if( m_dirty )
+            {
+                m_buffer.setData(m_lights);
+                m_dirty = false;
+            }
+
+            m_buffer.bindBase(UNIFORM_BLOCK_ITEM_LIGHTING_BINDING);
+        }
+
+
+        //! Makes nodes use the entry of unlit nodes unless they override it, see engine::items::ItemNode::bindLighting()
+        static void bindDefaults(gameplay::Material& material)
+        {
+            material.getParameter("u_itemLight")->set(0);
+        }
+
+
+    private:
+        std::array<Light, MaxLights> m_lights{};
+        size_t m_used = 1;
+        //! Released entries below m_used
+        std::vector<GLint> m_free;
+        bool m_dirty = true;
+        gameplay::gl::UniformBuffer m_buffer{"item lighting"};
+    };
+}
@@ -2,149 +2,133 @@
 
 #include "loader/texture.h"
 
-#include "Mesh.h"
+#include "Material.h"
 
 #include <boost/assert.hpp>
 
+#include <algorithm>
 #include <map>
-#include <set>
 #include <vector>
 
 
 namespace render
 {
+    /**
+     * @brief Animates textures by rotating the texture coordinates of sequences of proxies.
+     *
+     * The texture coordinates of all sequences are uploaded once into a lookup texture, with a row per
+     * sequence holding its length in the first texel, followed by the coordinates of the corners of
+     * each of its proxies.  Animated vertices reference their sequence, the position of their proxy
+     * within it, and their corner, see getVertexAttribute(); the vertex shader then picks the
+     * coordinates of the current frame, so animating costs nothing but incrementing the frame.
+     */
     class TextureAnimator
     {
-        struct Sequence
-        {
-            struct VertexReference
-            {
-                //! Vertex buffer index
-                const size_t bufferIndex;
-                const int sourceIndex;
-                size_t queueOffset = 0;
-
-
-                VertexReference(size_t bufferIdx, int sourceIdx)
-                    : bufferIndex(bufferIdx)
-                    , sourceIndex(sourceIdx)
-                {
-                    Expects(sourceIdx >= 0 && sourceIdx < 4);
-                }
-
+        std::vector<std::vector<uint16_t>> m_sequences;
+        //! Maps the proxy ids to their sequence and their position within it
+        std::map<uint16_t, std::pair<size_t, size_t>> m_sequenceByProxyId;
+        std::shared_ptr<gameplay::gl::Texture> m_lookupTexture;
+        GLint m_frame = 0;
 
-                bool operator<(const VertexReference& rhs) const noexcept
-                {
-                    return bufferIndex < rhs.bufferIndex;
-                }
+    public:
+        explicit TextureAnimator(const std::vector<uint16_t>& data,
+                                 const std::vector<loader::TextureLayoutProxy>& proxies,
+                                 uint16_t textureIndexMask)
+        {
+            /*
+             * We have N rotating sequences, each consisting of M+1 proxy ids.
+             */
 
+            size_t maxSequenceLength = 0;
+            if( !data.empty() )
+            {
+                const uint16_t* ptr = data.data();
+                const auto sequenceCount = *ptr++;
 
-                bool operator==(const VertexReference& rhs) const noexcept
+                for( size_t i = 0; i < sequenceCount; ++i )
                 {
-                    return bufferIndex == rhs.bufferIndex;
+                    std::vector<uint16_t> sequence;
+                    const auto n = *ptr++;
+                    for( size_t j = 0; j <= n; ++j )
+                    {
+                        BOOST_ASSERT(ptr <= &data.back());
+                        const auto proxyId = *ptr++;
+                        m_sequenceByProxyId.insert(std::make_pair(proxyId, std::make_pair(m_sequences.size(), sequence.size())));
+                        sequence.emplace_back(proxyId);
+                    }
+                    maxSequenceLength = std::max(maxSequenceLength, sequence.size());
+                    m_sequences.emplace_back(std::move(sequence));
                 }
-            };
-
-
-            std::vector<uint16_t> proxyIds;
-            std::map<std::shared_ptr<gameplay::Mesh>, std::set<VertexReference>> affectedVertices;
-
-
-            void rotate()
-            {
-                BOOST_ASSERT(!proxyIds.empty());
-                auto first = proxyIds.front();
-                proxyIds.erase(proxyIds.begin(), std::next(proxyIds.begin()));
-                proxyIds.emplace_back(first);
             }
 
-
-            void registerVertex(const std::shared_ptr<gameplay::Mesh>& mesh, VertexReference vertex, uint16_t proxyId)
+            const auto width = gsl::narrow<GLint>(1 + 4 * maxSequenceLength);
+            const auto height = gsl::narrow<GLint>(std::max(m_sequences.size(), size_t(1)));
+            std::vector<gameplay::gl::RGBF> lookup(static_cast<size_t>(width) * static_cast<size_t>(height), gameplay::gl::RGBF{0.0f});
+            for( size_t i = 0; i < m_sequences.size(); ++i )
             {
-                //! @fixme Expects(mesh->getVertexFormat().getElement(0).usage == gameplay::VertexFormat::TEXCOORD);
-
-                auto it = std::find(proxyIds.begin(), proxyIds.end(), proxyId);
-                Expects(it != proxyIds.end());
-                vertex.queueOffset = std::distance(proxyIds.begin(), it);
-                affectedVertices[mesh].insert(vertex);
-            }
-
-
-            void updateCoordinates(const std::vector<loader::TextureLayoutProxy>& proxies)
-            {
-                BOOST_ASSERT(!proxyIds.empty());
-
-                for( const auto& partAndVertices : affectedVertices )
+                const auto& sequence = m_sequences[i];
+                auto* row = &lookup[i * width];
+                row[0].r = static_cast<float>(sequence.size());
+                for( size_t j = 0; j < sequence.size(); ++j )
                 {
-                    const std::shared_ptr<gameplay::Mesh>& mesh = partAndVertices.first;
-                    BOOST_ASSERT(mesh->getBuffers().size() == 2);
-
-                    auto* uvArray = mesh->getBuffer(1).mapTypedRw<glm::vec2>();
-
-                    const std::set<VertexReference>& vertices = partAndVertices.second;
-
-                    for( const VertexReference& vref : vertices )
+                    BOOST_ASSERT(sequence[j] < proxies.size());
+                    const loader::TextureLayoutProxy& proxy = proxies[sequence[j]];
+                    // the proxies of a sequence may reference different texture pages
+                    const auto layer = static_cast<float>(proxy.textureKey.tileAndFlag & textureIndexMask);
+                    for( size_t corner = 0; corner < 4; ++corner )
                     {
-                        BOOST_ASSERT(vref.bufferIndex < mesh->getBuffer(1).getVertexCount());
-                        BOOST_ASSERT(vref.queueOffset < proxyIds.size());
-                        const loader::TextureLayoutProxy& proxy = proxies[proxyIds[vref.queueOffset]];
-
-                        uvArray[vref.bufferIndex] = proxy.uvCoordinates[vref.sourceIndex].toGl();
+                        const auto uv = proxy.uvCoordinates[corner].toGl();
+                        row[1 + 4 * j + corner] = gameplay::gl::RGBF{uv.x, uv.y, layer};
                     }
-
-                    mesh->getBuffer(1).unmap();
                 }
             }
-        };
 
+            m_lookupTexture = std::make_shared<gameplay::gl::Texture>(GL_TEXTURE_2D, "animated textures");
+            m_lookupTexture->image2D(width, height, lookup, false);
+            m_lookupTexture->set(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            m_lookupTexture->set(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
 
-        std::vector<Sequence> m_sequences;
-        std::map<uint16_t, size_t> m_sequenceByProxyId;
 
-    public:
-        explicit TextureAnimator(const std::vector<uint16_t>& data)
+        /**
+         * @brief The value of the texture animation vertex attribute.
+         *
+         * @returns The sequence + 1, the position of the proxy within the sequence and the corner,
+         *          or zero if the proxy is not animated.
+         */
+        glm::vec3 getVertexAttribute(uint16_t proxyId, int sourceIndex) const
         {
-            /*
-             * We have N rotating sequences, each consisting of M+1 proxy ids.
-             */
+            Expects(sourceIndex >= 0 && sourceIndex < 4);
 
-            const uint16_t* ptr = data.data();
-            const auto sequenceCount = *ptr++;
+            const auto it = m_sequenceByProxyId.find(proxyId);
+            if( it == m_sequenceByProxyId.end() )
+                return glm::vec3{0.0f};
 
-            for( size_t i = 0; i < sequenceCount; ++i )
-            {
-                Sequence sequence;
-                const auto n = *ptr++;
-                for( size_t j = 0; j <= n; ++j )
-                {
-                    BOOST_ASSERT(ptr <= &data.back());
-                    const auto proxyId = *ptr++;
-                    sequence.proxyIds.emplace_back(proxyId);
-                    m_sequenceByProxyId.insert(std::make_pair(proxyId, m_sequences.size()));
-                }
-                m_sequences.emplace_back(std::move(sequence));
-            }
+            return glm::vec3{static_cast<float>(it->second.first + 1), static_cast<float>(it->second.second), static_cast<float>(sourceIndex)};
         }
 
 
-        void registerVertex(uint16_t proxyId, const std::shared_ptr<gameplay::Mesh>& mesh, int sourceIndex, size_t bufferIndex)
+        //! Binds the lookup texture and the frame counter to a material using an animated texture shader.
+        void bind(gameplay::Material& material) const
         {
-            if( m_sequenceByProxyId.find(proxyId) == m_sequenceByProxyId.end() )
-                return;
+            material.getParameter("u_animatedTextures")->set(m_lookupTexture);
+            material.getParameter("u_textureAnimationFrame")->bind([this](const gameplay::Node& /*node*/, gameplay::gl::Program::ActiveUniform& uniform)
+            {
+                uniform.set(m_frame);
+            });
+        }
+
 
-            const size_t sequenceId = m_sequenceByProxyId[proxyId];
-            Expects(sequenceId < m_sequences.size());
-            m_sequences[sequenceId].registerVertex(mesh, Sequence::VertexReference(bufferIndex, sourceIndex), proxyId);
+        //! Advances all sequences to their next proxy.
+        void update()
+        {
+            ++m_frame;
         }
 
 
-        void updateCoordinates(const std::vector<loader::TextureLayoutProxy>& proxies)
+        GLint getFrame() const noexcept
         {
-            for( Sequence& sequence : m_sequences )
-            {
-                sequence.rotate();
-                sequence.updateCoordinates(proxies);
-            }
+            return m_frame;
         }
     };
 }
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+namespace render
+{
+    namespace detail
+    {
+        //! The size of the simulated post-transform cache; larger than most hardware caches, which doesn't hurt them
+        constexpr int VertexCacheSize = 32;
+
+
+        inline float getVertexCacheScore(int cachePosition, size_t remainingTriangles)
+        {
+            if( remainingTriangles == 0 )
+                return -1;
+
+            float score = 0;
+            if( cachePosition >= 0 )
+            {
+                if( cachePosition < 3 )
+                {
+                    // the vertices of the last triangle get a fixed score, so that strips aren't favoured
+                    score = 0.75f;
+                }
+                else
+                {
+                    score = std::pow(1.0f - (cachePosition - 3) / static_cast<float>(VertexCacheSize - 3), 1.5f);
+                }
+            }
+
+            // boost vertices with few triangles left, so that no isolated triangles are left behind
+            return score + 2.0f / std::sqrt(static_cast<float>(remainingTriangles));
+        }
+    }
+
+
+    /**
+     * @brief Reorders the triangles of an indexed triangle list for the post-transform vertex cache.
+     *
+     * Implements Tom Forsyth's "Linear-Speed Vertex Cache Optimisation": the triangle emitted next is
+     * the one with the best scoring vertices among those in a simulated LRU cache, where vertices score
+     * higher the more recently they were used and the fewer triangles still reference them.
+     *
+     * @param indices The triangle list to reorder in place.
+     * @param vertexCount The number of vertices referenced by @a indices.
+     */
+    template<typename T>
+    void optimizeVertexCache(std::vector<T>& indices, size_t vertexCount)
+    {
+        BOOST_ASSERT(indices.size() % 3 == 0);
+
+        const size_t triangleCount = indices.size() / 3;
+        if( triangleCount < 2 )
+            return;
+
+        struct Vertex
+        {
+            int cachePosition = -1;
+            float score = 0;
+            //! The live triangles of the vertex are the first remainingTriangles entries in vertexTriangles
+            size_t firstTriangle = 0;
+            size_t remainingTriangles = 0;
+        };
+
+        std::vector<Vertex> vertices(vertexCount);
+        for( const auto idx : indices )
+        {
+            BOOST_ASSERT(idx < vertexCount);
+            ++vertices[idx].remainingTriangles;
+        }
+
+        std::vector<size_t> vertexTriangles(indices.size());
+        size_t offset = 0;
+        for( Vertex& vertex : vertices )
+        {
+            vertex.firstTriangle = offset;
+            offset += vertex.remainingTriangles;
+            vertex.remainingTriangles = 0;
+        }
+        for( size_t triangle = 0; triangle < triangleCount; ++triangle )
+        {
+            for( size_t corner = 0; corner < 3; ++corner )
+            {
+                Vertex& vertex = vertices[indices[3 * triangle + corner]];
+                vertexTriangles[vertex.firstTriangle + vertex.remainingTriangles++] = triangle;
+            }
+        }
+
+        for( Vertex& vertex : vertices )
+            vertex.score = detail::getVertexCacheScore(-1, vertex.remainingTriangles);
+
+        const auto getTriangleScore = [&](size_t triangle)
+        {
+            return vertices[indices[3 * triangle + 0]].score
+                   + vertices[indices[3 * triangle + 1]].score
+                   + vertices[indices[3 * triangle + 2]].score;
+        };
+
+        size_t best = 0;
+        float bestScore = -1;
+        for( size_t triangle = 0; triangle < triangleCount; ++triangle )
+        {
+            const auto score = getTriangleScore(triangle);
+            if( score > bestScore )
+            {
+                bestScore = score;
+                best = triangle;
+            }
+        }
+
+        std::vector<T> result;
+        result.reserve(indices.size());
+        std::vector<bool> emitted(triangleCount, false);
+        size_t nextUnemitted = 0;
+        std::vector<T> cache;
+        std::vector<T> newCache;
+
+        while( true )
+        {
+            emitted[best] = true;
+
+            newCache.clear();
+            for( size_t corner = 0; corner < 3; ++corner )
+            {
+                const T idx = indices[3 * best + corner];
+                result.emplace_back(idx);
+                newCache.emplace_back(idx);
+
+                Vertex& vertex = vertices[idx];
+                const auto begin = vertexTriangles.begin() + vertex.firstTriangle;
+                const auto end = begin + vertex.remainingTriangles;
+                const auto it = std::find(begin, end, best);
+                BOOST_ASSERT(it != end);
+                std::iter_swap(it, end - 1);
+                --vertex.remainingTriangles;
+            }
+
+            if( result.size() == indices.size() )
+                break;
+
+            for( const auto idx : cache )
+            {
+                if( std::find(newCache.begin(), newCache.begin() + 3, idx) == newCache.begin() + 3 )
+                    newCache.emplace_back(idx);
+            }
+
+            while( newCache.size() > static_cast<size_t>(detail::VertexCacheSize) )
+            {
+                const auto idx = newCache.back();
+                newCache.pop_back();
+                vertices[idx].cachePosition = -1;
+                vertices[idx].score = detail::getVertexCacheScore(-1, vertices[idx].remainingTriangles);
+            }
+
+            std::swap(cache, newCache);
+            for( size_t i = 0; i < cache.size(); ++i )
+            {
+                Vertex& vertex = vertices[cache[i]];
+                vertex.cachePosition = static_cast<int>(i);
+                vertex.score = detail::getVertexCacheScore(vertex.cachePosition, vertex.remainingTriangles);
+            }
+
+            // only the triangles of the cached vertices are candidates, as the others' scores didn't increase
+            bestScore = -1;
+            for( const auto idx : cache )
+            {
+                const Vertex& vertex = vertices[idx];
+                for( size_t i = 0; i < vertex.remainingTriangles; ++i )
+                {
+                    const auto triangle = vertexTriangles[vertex.firstTriangle + i];
+                    const auto score = getTriangleScore(triangle);
+                    if( score > bestScore )
+                    {
+                        bestScore = score;
+                        best = triangle;
+                    }
+                }
+            }
+
+            if( bestScore < 0 )
+            {
+                // the cached vertices have no triangles left, so continue with another part of the mesh
+                while( emitted[nextUnemitted] )
+                    ++nextUnemitted;
+                best = nextUnemitted;
+            }
+        }
+
+        indices = std::move(result);
+    }
+}
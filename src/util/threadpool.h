@@ -0,0 +1,95 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace util
+{
+    /**
+     * @brief A fixed set of worker threads processing jobs in the order they were enqueued.
+     *
+     * A job may wait for the result of any job that was enqueued before it: such a job has already
+     * been started by another worker, so waiting for it can't dead-lock the pool.
+     *
+     * The destructor finishes all pending jobs before joining the workers.
+     */
+    class ThreadPool final : public boost::noncopyable
+    {
+    public:
+        explicit ThreadPool(size_t threadCount = std::max(1u, std::thread::hardware_concurrency()))
+        {
+            for( size_t i = 0; i < threadCount; ++i )
+                m_workers.emplace_back([this]() { run(); });
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_stop = true;
+            }
+            m_condition.notify_all();
+
+            for( auto& worker : m_workers )
+                worker.join();
+        }
+
+        template<typename F>
+        auto enqueue(F&& job) -> std::future<decltype(job())>
+        {
+            using Result = decltype(job());
+
+            // std::function needs a copyable target, but jobs may own move-only state
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+            auto result = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_jobs.emplace_back([task]() { (*task)(); });
+            }
+            m_condition.notify_one();
+
+            return result;
+        }
+
+        size_t getThreadCount() const noexcept
+        {
+            return m_workers.size();
+        }
+
+    private:
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_jobs;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_stop = false;
+
+        void run()
+        {
+            while( true )
+            {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_condition.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+
+                    if( m_jobs.empty() )
+                        return;
+
+                    job = std::move(m_jobs.front());
+                    m_jobs.pop_front();
+                }
+
+                job();
+            }
+        }
+    };
+}